@@ -50,6 +50,9 @@ WINE_DEFAULT_DEBUG_CHANNEL(reg);
 #define HKEY_SPECIAL_ROOT_FIRST   HKEY_CLASSES_ROOT
 #define HKEY_SPECIAL_ROOT_LAST    HKEY_DYN_DATA
 
+/* max. buffer size to allocate before knowing the size of a value */
+#define MAX_QUERY_PREALLOC        0x10000
+
 static const WCHAR name_CLASSES_ROOT[] =
     {'\\','R','e','g','i','s','t','r','y','\\',
      'M','a','c','h','i','n','e','\\',
@@ -1782,7 +1785,14 @@ LSTATUS WINAPI DECLSPEC_HOTPATCH RegQueryValueExW( HKEY hkey, LPCWSTR name, LPDW
 
     RtlInitUnicodeString( &name_str, name );
 
-    if (data) total_size = min( sizeof(buffer), *count + info_size );
+    if (data)
+    {
+        total_size = min( *count, MAX_QUERY_PREALLOC ) + info_size;
+        /* allocate the buffer up front if needed, to save a server round trip */
+        if (total_size > sizeof(buffer) && !(buf_ptr = heap_alloc( total_size )))
+            return ERROR_NOT_ENOUGH_MEMORY;
+        info = (KEY_VALUE_PARTIAL_INFORMATION *)buf_ptr;
+    }
     else
     {
         total_size = info_size;
@@ -1790,7 +1800,7 @@ LSTATUS WINAPI DECLSPEC_HOTPATCH RegQueryValueExW( HKEY hkey, LPCWSTR name, LPDW
     }
 
     status = NtQueryValueKey( hkey, &name_str, KeyValuePartialInformation,
-                              buffer, total_size, &total_size );
+                              buf_ptr, total_size, &total_size );
     if (status && status != STATUS_BUFFER_OVERFLOW) goto done;
 
     if (data)
@@ -1888,8 +1898,21 @@ LSTATUS WINAPI DECLSPEC_HOTPATCH RegQueryValueExA( HKEY hkey, LPCSTR name, LPDWO
         return ret;
     }
 
+    /* allocate the buffer up front if needed, to save a server round trip */
+    total_size = sizeof(buffer);
+    if (data && datalen > (sizeof(buffer) - info_size) / sizeof(WCHAR))
+    {
+        total_size = min( datalen, MAX_QUERY_PREALLOC / sizeof(WCHAR) ) * sizeof(WCHAR) + info_size;
+        if (!(buf_ptr = heap_alloc( total_size )))
+        {
+            RtlFreeUnicodeString( &nameW );
+            return ERROR_NOT_ENOUGH_MEMORY;
+        }
+        info = (KEY_VALUE_PARTIAL_INFORMATION *)buf_ptr;
+    }
+
     status = NtQueryValueKey( hkey, &nameW, KeyValuePartialInformation,
-                              buffer, sizeof(buffer), &total_size );
+                              buf_ptr, total_size, &total_size );
     if (status && status != STATUS_BUFFER_OVERFLOW) goto done;
 
     /* we need to fetch the contents for a string type even if not requested,
@@ -22,6 +22,7 @@
 
 #include "gdi_private.h"
 #include "dibdrv.h"
+#include "winternl.h"
 
 #include "wine/debug.h"
 
@@ -581,19 +582,125 @@ static void mask_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src,
     }
 }
 
+/* Large operations are split into horizontal bands which are processed in parallel.
+ * Each band only touches its own rows, so the result is the same as in the serial case. */
+#define MIN_BAND_PIXELS  (256 * 256)
+#define MAX_BANDS        8
+
+struct band_work
+{
+    void  (*func)( void *ctx, const RECT *rect );
+    void   *ctx;
+    RECT    rect;
+    int     count;
+    LONG    next;
+};
+
+static int max_bands;
+
+static void process_bands( struct band_work *bands )
+{
+    int i, height = bands->rect.bottom - bands->rect.top;
+    RECT rect = bands->rect;
+
+    while ((i = InterlockedIncrement( &bands->next ) - 1) < bands->count)
+    {
+        rect.top    = bands->rect.top + height * i / bands->count;
+        rect.bottom = bands->rect.top + height * (i + 1) / bands->count;
+        bands->func( bands->ctx, &rect );
+    }
+}
+
+static void CALLBACK band_work_proc( TP_CALLBACK_INSTANCE *instance, void *param, TP_WORK *work )
+{
+    process_bands( param );
+}
+
+static BOOL CALLBACK init_max_bands( INIT_ONCE *once, void *param, void **context )
+{
+    SYSTEM_INFO info;
+
+    GetSystemInfo( &info );
+    max_bands = min( max( info.dwNumberOfProcessors, 1 ), MAX_BANDS );
+    return TRUE;
+}
+
+static int get_band_count( const RECT *rect )
+{
+    static INIT_ONCE init_once = INIT_ONCE_STATIC_INIT;
+    int count, height = rect->bottom - rect->top;
+
+    InitOnceExecuteOnce( &init_once, init_max_bands, NULL, NULL );
+    count = (LONGLONG)(rect->right - rect->left) * height / MIN_BAND_PIXELS;
+    return max( min( min( count, max_bands ), height ), 1 );
+}
+
+static void run_in_bands( const RECT *rect, void (*func)( void *ctx, const RECT *rect ), void *ctx )
+{
+    struct band_work bands;
+    TP_WORK *work;
+    int i;
+
+    bands.func  = func;
+    bands.ctx   = ctx;
+    bands.rect  = *rect;
+    bands.count = get_band_count( rect );
+    bands.next  = 0;
+
+    /* new pool threads can't get through thread attach while we hold the loader lock */
+    if (bands.count == 1 || RtlIsCriticalSectionLockedByThread( NtCurrentTeb()->Peb->LoaderLock ) ||
+        !(work = CreateThreadpoolWork( band_work_proc, &bands, NULL )))
+    {
+        func( ctx, rect );
+        return;
+    }
+
+    for (i = 1; i < bands.count; i++) SubmitThreadpoolWork( work );
+
+    /* The caller takes all the bands that no worker has picked up yet, and the callbacks
+     * that haven't started by then are cancelled, so we never wait for the pool to schedule
+     * them. This matters when the pool is busy, or when we are running in a pool thread. */
+    process_bands( &bands );
+    WaitForThreadpoolWorkCallbacks( work, TRUE );
+    CloseThreadpoolWork( work );
+}
+
+struct blend_rect_params
+{
+    dib_info       *dst;
+    const dib_info *src;
+    POINT           origin;
+    const RECT     *rect;
+    BLENDFUNCTION   blend;
+};
+
+static void blend_rect_band( void *ctx, const RECT *rect )
+{
+    struct blend_rect_params *params = ctx;
+    POINT origin;
+
+    origin.x = params->origin.x + rect->left - params->rect->left;
+    origin.y = params->origin.y + rect->top  - params->rect->top;
+    params->dst->funcs->blend_rect( params->dst, rect, params->src, &origin, params->blend );
+}
+
 static DWORD blend_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src, const RECT *src_rect,
                          HRGN clip, BLENDFUNCTION blend )
 {
-    POINT origin;
+    struct blend_rect_params params;
     struct clipped_rects clipped_rects;
     int i;
 
     if (!get_clipped_rects( dst, dst_rect, clip, &clipped_rects )) return ERROR_SUCCESS;
+    params.dst   = dst;
+    params.src   = src;
+    params.blend = blend;
     for (i = 0; i < clipped_rects.count; i++)
     {
-        origin.x = src_rect->left + clipped_rects.rects[i].left - dst_rect->left;
-        origin.y = src_rect->top  + clipped_rects.rects[i].top  - dst_rect->top;
-        dst->funcs->blend_rect( dst, &clipped_rects.rects[i], src, &origin, blend );
+        params.origin.x = src_rect->left + clipped_rects.rects[i].left - dst_rect->left;
+        params.origin.y = src_rect->top  + clipped_rects.rects[i].top  - dst_rect->top;
+        params.rect = &clipped_rects.rects[i];
+        run_in_bands( &clipped_rects.rects[i], blend_rect_band, &params );
     }
     free_clipped_rects( &clipped_rects );
     return ERROR_SUCCESS;
@@ -678,19 +785,37 @@ static void get_gradient_triangle_vertices( const GRADIENT_TRIANGLE *tri, const
     bounds->bottom = v[2].y;
 }
 
+struct gradient_rect_params
+{
+    dib_info       *dib;
+    const TRIVERTEX *v;
+    int             mode;
+    BOOL            ret;
+};
+
+static void gradient_rect_band( void *ctx, const RECT *rect )
+{
+    struct gradient_rect_params *params = ctx;
+
+    if (!params->dib->funcs->gradient_rect( params->dib, rect, params->v, params->mode ))
+        params->ret = FALSE;
+}
+
 static BOOL gradient_rect( dib_info *dib, TRIVERTEX *v, int mode, HRGN clip, const RECT *bounds )
 {
     int i;
     struct clipped_rects clipped_rects;
-    BOOL ret = TRUE;
+    struct gradient_rect_params params;
 
     if (!get_clipped_rects( dib, bounds, clip, &clipped_rects )) return TRUE;
-    for (i = 0; i < clipped_rects.count; i++)
-    {
-        if (!(ret = dib->funcs->gradient_rect( dib, &clipped_rects.rects[i], v, mode ))) break;
-    }
+    params.dib  = dib;
+    params.v    = v;
+    params.mode = mode;
+    params.ret  = TRUE;
+    for (i = 0; i < clipped_rects.count && params.ret; i++)
+        run_in_bands( &clipped_rects.rects[i], gradient_rect_band, &params );
     free_clipped_rects( &clipped_rects );
-    return ret;
+    return params.ret;
 }
 
 static DWORD copy_src_bits( dib_info *src, RECT *src_rect )
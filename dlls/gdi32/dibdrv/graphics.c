@@ -43,10 +43,16 @@ enum glyph_type
 #define GLYPH_CACHE_PAGE_SIZE  0x100
 #define GLYPH_CACHE_PAGES      (0x10000 / GLYPH_CACHE_PAGE_SIZE)
 
+/* unused fonts are evicted once there are more than that many of them,
+ * or once their glyphs take more than that many bytes */
+#define FONT_CACHE_MAX_UNUSED  5
+#define FONT_CACHE_MAX_SIZE    (16 * 1024 * 1024)
+
 struct cached_font
 {
     struct list           entry;
     LONG                  ref;
+    LONG                  size;
     DWORD                 hash;
     LOGFONTW              lf;
     XFORM                 xform;
@@ -56,6 +62,12 @@ struct cached_font
 
 static struct list font_cache = LIST_INIT( font_cache );
 
+/* cache statistics */
+static LONG font_cache_size;
+static LONG font_cache_hits;
+static LONG font_cache_misses;
+static LONG font_cache_evictions;
+
 static CRITICAL_SECTION font_cache_cs;
 static CRITICAL_SECTION_DEBUG critsect_debug =
 {
@@ -554,10 +566,33 @@ static int font_cache_cmp( const struct cached_font *p1, const struct cached_fon
     return ret;
 }
 
+static void free_cached_font( struct cached_font *font )
+{
+    UINT i, j, k;
+
+    TRACE( "evicting %p, %d bytes\n", font, font->size );
+
+    for (i = 0; i < GLYPH_NBTYPES; i++)
+    {
+        for (j = 0; j < GLYPH_CACHE_PAGES; j++)
+        {
+            if (!font->glyphs[i][j]) continue;
+            for (k = 0; k < GLYPH_CACHE_PAGE_SIZE; k++)
+                HeapFree( GetProcessHeap(), 0, font->glyphs[i][j][k] );
+            HeapFree( GetProcessHeap(), 0, font->glyphs[i][j] );
+        }
+    }
+    InterlockedExchangeAdd( &font_cache_size, -font->size );
+    font_cache_evictions++;
+    list_remove( &font->entry );
+    HeapFree( GetProcessHeap(), 0, font );
+}
+
 static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
 {
-    struct cached_font font, *ptr, *last_unused = NULL;
-    UINT i = 0, j, k;
+    struct cached_font font, *ptr, *next;
+    UINT unused = 0;
+    LONG unused_size = 0;
 
     GetObjectW( hfont, sizeof(font.lf), &font.lf );
     font.xform = dc->xformWorld2Vport;
@@ -583,27 +618,26 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
         }
         if (!ptr->ref)
         {
-            i++;
-            last_unused = ptr;
+            unused++;
+            unused_size += ptr->size;
         }
     }
 
-    if (i > 5)  /* keep at least 5 of the most-recently used fonts around */
+    /* evict the least recently used fonts that are no longer selected anywhere,
+     * the glyphs of selected fonts don't count against the size limit */
+    LIST_FOR_EACH_ENTRY_SAFE_REV( ptr, next, &font_cache, struct cached_font, entry )
     {
-        ptr = last_unused;
-        for (i = 0; i < GLYPH_NBTYPES; i++)
-        {
-            for (j = 0; j < GLYPH_CACHE_PAGES; j++)
-            {
-                if (!ptr->glyphs[i][j]) continue;
-                for (k = 0; k < GLYPH_CACHE_PAGE_SIZE; k++)
-                    HeapFree( GetProcessHeap(), 0, ptr->glyphs[i][j][k] );
-                HeapFree( GetProcessHeap(), 0, ptr->glyphs[i][j] );
-            }
-        }
-        list_remove( &ptr->entry );
+        if (unused <= FONT_CACHE_MAX_UNUSED && unused_size <= FONT_CACHE_MAX_SIZE) break;
+        if (ptr->ref) continue;
+        unused--;
+        unused_size -= ptr->size;
+        free_cached_font( ptr );
     }
-    else if (!(ptr = HeapAlloc( GetProcessHeap(), 0, sizeof(*ptr) )))
+
+    TRACE( "glyph cache: %d bytes, %d hits, %d misses, %d evicted fonts\n",
+           font_cache_size, font_cache_hits, font_cache_misses, font_cache_evictions );
+
+    if (!(ptr = HeapAlloc( GetProcessHeap(), 0, sizeof(*ptr) )))
     {
         LeaveCriticalSection( &font_cache_cs );
         return NULL;
@@ -611,6 +645,7 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
 
     *ptr = font;
     ptr->ref = 1;
+    ptr->size = 0;
     memset( ptr->glyphs, 0, sizeof(ptr->glyphs) );
 done:
     list_add_head( &font_cache, &ptr->entry );
@@ -625,7 +660,7 @@ void release_cached_font( struct cached_font *font )
 }
 
 static struct cached_glyph *add_cached_glyph( struct cached_font *font, UINT index, UINT flags,
-                                              struct cached_glyph *glyph )
+                                              struct cached_glyph *glyph, DWORD size )
 {
     struct cached_glyph *ret;
     enum glyph_type type = (flags & ETO_GLYPH_INDEX) ? GLYPH_INDEX : GLYPH_WCHAR;
@@ -646,7 +681,12 @@ static struct cached_glyph *add_cached_glyph( struct cached_font *font, UINT ind
             HeapFree( GetProcessHeap(), 0, ptr );
     }
     ret = InterlockedCompareExchangePointer( (void **)&font->glyphs[type][page][entry], glyph, NULL );
-    if (!ret) ret = glyph;
+    if (!ret)
+    {
+        InterlockedExchangeAdd( &font->size, size );
+        InterlockedExchangeAdd( &font_cache_size, size );
+        ret = glyph;
+    }
     else HeapFree( GetProcessHeap(), 0, glyph );
     return ret;
 }
@@ -767,6 +807,7 @@ static struct cached_glyph *cache_glyph_bitmap( DC *dc, struct cached_font *font
     }
     if (ret == GDI_ERROR) return NULL;
     if (!ret) metrics.gmBlackBoxX = metrics.gmBlackBoxY = 0; /* empty glyph */
+    if (TRACE_ON(dib)) InterlockedIncrement( &font_cache_misses );
 
     bit_count = get_glyph_depth( font->aa_flags );
     stride = get_dib_stride( metrics.gmBlackBoxX, bit_count );
@@ -805,14 +846,14 @@ static struct cached_glyph *cache_glyph_bitmap( DC *dc, struct cached_font *font
 
 done:
     glyph->metrics = metrics;
-    return add_cached_glyph( font, index, flags, glyph );
+    return add_cached_glyph( font, index, flags, glyph, FIELD_OFFSET( struct cached_glyph, bits[size] ));
 }
 
 static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT x, INT y,
                            UINT flags, const WCHAR *str, UINT count, const INT *dx,
                            const struct clipped_rects *clipped_rects, RECT *bounds )
 {
-    UINT i;
+    UINT i, hits = 0;
     struct cached_glyph *glyph;
     dib_info glyph_dib;
     DWORD text_color;
@@ -833,8 +874,8 @@ static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT
 
     for (i = 0; i < count; i++)
     {
-        if (!(glyph = get_cached_glyph( font, str[i], flags )) &&
-            !(glyph = cache_glyph_bitmap( dc, font, str[i], flags ))) continue;
+        if ((glyph = get_cached_glyph( font, str[i], flags ))) hits++;
+        else if (!(glyph = cache_glyph_bitmap( dc, font, str[i], flags ))) continue;
 
         glyph_dib.width       = glyph->metrics.gmBlackBoxX;
         glyph_dib.height      = glyph->metrics.gmBlackBoxY;
@@ -861,6 +902,7 @@ static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT
             y += glyph->metrics.gmCellIncY;
         }
     }
+    if (hits && TRACE_ON(dib)) InterlockedExchangeAdd( &font_cache_hits, hits );
 }
 
 BOOL render_aa_text_bitmapinfo( DC *dc, BITMAPINFO *info, struct gdi_image_bits *bits,
@@ -4593,44 +4593,50 @@ static inline BYTE blend_color(BYTE dst, BYTE src, DWORD alpha)
     return (src * alpha + dst * (255 - alpha) + 127) / 255;
 }
 
+/* Divide the two 16-bit lanes of val by 255, rounding to nearest. Each lane
+ * has to be at most 255 * 255, the result is the same as (x + 127) / 255. */
+static inline DWORD div255_lanes( DWORD val )
+{
+    val += 0x00800080;
+    return ((val + ((val >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+}
+
+/* The following helpers blend the red and blue, and the alpha and green
+ * channels in parallel, two channels in each 32-bit multiply. */
 static inline DWORD blend_argb_constant_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    return (blend_color( dst, src, alpha ) |
-            blend_color( dst >> 8, src >> 8, alpha ) << 8 |
-            blend_color( dst >> 16, src >> 16, alpha ) << 16 |
-            blend_color( dst >> 24, src >> 24, alpha ) << 24);
+    return (div255_lanes( (src & 0x00ff00ff) * alpha + (dst & 0x00ff00ff) * (255 - alpha) ) |
+            div255_lanes( ((src >> 8) & 0x00ff00ff) * alpha + ((dst >> 8) & 0x00ff00ff) * (255 - alpha) ) << 8);
 }
 
 static inline DWORD blend_argb_no_src_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    return (blend_color( dst, src, alpha ) |
-            blend_color( dst >> 8, src >> 8, alpha ) << 8 |
-            blend_color( dst >> 16, src >> 16, alpha ) << 16 |
-            blend_color( dst >> 24, 255, alpha ) << 24);
+    return blend_argb_constant_alpha( dst, src | 0xff000000, alpha );
 }
 
 static inline DWORD blend_argb( DWORD dst, DWORD src )
 {
-    BYTE b = (BYTE)src;
-    BYTE g = (BYTE)(src >> 8);
-    BYTE r = (BYTE)(src >> 16);
-    DWORD alpha  = (BYTE)(src >> 24);
-    return ((b     + ((BYTE)dst         * (255 - alpha) + 127) / 255) |
-            (g     + ((BYTE)(dst >> 8)  * (255 - alpha) + 127) / 255) << 8 |
-            (r     + ((BYTE)(dst >> 16) * (255 - alpha) + 127) / 255) << 16 |
-            (alpha + ((BYTE)(dst >> 24) * (255 - alpha) + 127) / 255) << 24);
+    DWORD alpha = src >> 24;
+    DWORD rb, ag;
+
+    if (alpha == 255) return src;
+    if (!src) return dst;
+
+    rb = div255_lanes( (dst & 0x00ff00ff) * (255 - alpha) ) + (src & 0x00ff00ff);
+    ag = div255_lanes( ((dst >> 8) & 0x00ff00ff) * (255 - alpha) ) + ((src >> 8) & 0x00ff00ff);
+    return rb | ag << 8;
 }
 
 static inline DWORD blend_argb_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    BYTE b = ((BYTE)src         * alpha + 127) / 255;
-    BYTE g = ((BYTE)(src >> 8)  * alpha + 127) / 255;
-    BYTE r = ((BYTE)(src >> 16) * alpha + 127) / 255;
-    alpha  = ((BYTE)(src >> 24) * alpha + 127) / 255;
-    return ((b     + ((BYTE)dst         * (255 - alpha) + 127) / 255) |
-            (g     + ((BYTE)(dst >> 8)  * (255 - alpha) + 127) / 255) << 8 |
-            (r     + ((BYTE)(dst >> 16) * (255 - alpha) + 127) / 255) << 16 |
-            (alpha + ((BYTE)(dst >> 24) * (255 - alpha) + 127) / 255) << 24);
+    DWORD src_rb = div255_lanes( (src & 0x00ff00ff) * alpha );
+    DWORD src_ag = div255_lanes( ((src >> 8) & 0x00ff00ff) * alpha );
+    DWORD rb, ag;
+
+    alpha = src_ag >> 16;
+    rb = div255_lanes( (dst & 0x00ff00ff) * (255 - alpha) ) + src_rb;
+    ag = div255_lanes( ((dst >> 8) & 0x00ff00ff) * (255 - alpha) ) + src_ag;
+    return rb | ag << 8;
 }
 
 static inline DWORD blend_rgb( BYTE dst_r, BYTE dst_g, BYTE dst_b, DWORD src, BLENDFUNCTION blend )
@@ -575,20 +575,28 @@ static const WCHAR wine_fonts_key[] = {'S','o','f','t','w','a','r','e','\\','W',
                                        'F','o','n','t','s',0};
 static const WCHAR wine_fonts_cache_key[] = {'C','a','c','h','e',0};
 static const WCHAR english_name_value[] = {'E','n','g','l','i','s','h',' ','N','a','m','e',0};
-static const WCHAR face_index_value[] = {'I','n','d','e','x',0};
-static const WCHAR face_ntmflags_value[] = {'N','t','m','f','l','a','g','s',0};
-static const WCHAR face_version_value[] = {'V','e','r','s','i','o','n',0};
-static const WCHAR face_height_value[] = {'H','e','i','g','h','t',0};
-static const WCHAR face_width_value[] = {'W','i','d','t','h',0};
-static const WCHAR face_size_value[] = {'S','i','z','e',0};
-static const WCHAR face_x_ppem_value[] = {'X','p','p','e','m',0};
-static const WCHAR face_y_ppem_value[] = {'Y','p','p','e','m',0};
-static const WCHAR face_flags_value[] = {'F','l','a','g','s',0};
-static const WCHAR face_internal_leading_value[] = {'I','n','t','e','r','n','a','l',' ','L','e','a','d','i','n','g',0};
-static const WCHAR face_font_sig_value[] = {'F','o','n','t',' ','S','i','g','n','a','t','u','r','e',0};
+static const WCHAR face_data_value[] = {'F','a','c','e',' ','D','a','t','a',0};
 static const WCHAR face_file_name_value[] = {'F','i','l','e',' ','N','a','m','e','\0'};
 static const WCHAR face_full_name_value[] = {'F','u','l','l',' ','N','a','m','e','\0'};
 
+/* fixed-size face properties, stored as a single binary value in the font cache
+ * so that loading a face only needs a few registry queries */
+struct cached_face_data
+{
+    DWORD         index;
+    DWORD         ntmflags;
+    DWORD         version;
+    DWORD         flags;
+    FONTSIGNATURE fs;
+    DWORD         scalable;
+    DWORD         height;
+    DWORD         width;
+    DWORD         size;
+    DWORD         x_ppem;
+    DWORD         y_ppem;
+    DWORD         internal_leading;
+};
+
 
 struct font_mapping
 {
@@ -1616,30 +1624,10 @@ static LONG reg_load_dword(HKEY hkey, const WCHAR *value, DWORD *data)
     return ERROR_SUCCESS;
 }
 
-static inline LONG reg_load_ftlong(HKEY hkey, const WCHAR *value, FT_Long *data)
-{
-    DWORD dw;
-    LONG ret = reg_load_dword(hkey, value, &dw);
-    *data = dw;
-    return ret;
-}
-
-static inline LONG reg_load_ftshort(HKEY hkey, const WCHAR *value, FT_Short *data)
-{
-    DWORD dw;
-    LONG ret = reg_load_dword(hkey, value, &dw);
-    *data = dw;
-    return ret;
-}
-
-static inline LONG reg_save_dword(HKEY hkey, const WCHAR *value, DWORD data)
-{
-    return RegSetValueExW(hkey, value, 0, REG_DWORD, (BYTE*)&data, sizeof(DWORD));
-}
-
 static void load_face(HKEY hkey_face, WCHAR *face_name, Family *family, void *buffer, DWORD buffer_size)
 {
-    DWORD needed, strike_index = 0;
+    DWORD type, needed, strike_index = 0;
+    struct cached_face_data data;
     HKEY hkey_strike;
 
     /* If we have a File Name key then this is a real font, not just the parent
@@ -1648,6 +1636,14 @@ static void load_face(HKEY hkey_face, WCHAR *face_name, Family *family, void *bu
     if (RegQueryValueExW(hkey_face, face_file_name_value, NULL, NULL, buffer, &needed) == ERROR_SUCCESS)
     {
         Face *face;
+
+        needed = sizeof(data);
+        if (RegQueryValueExW(hkey_face, face_data_value, NULL, &type, (BYTE *)&data, &needed) ||
+            type != REG_BINARY || needed != sizeof(data))
+        {
+            WARN("invalid cache entry for %s\n", debugstr_w(buffer));
+            goto strikes;
+        }
         face = HeapAlloc(GetProcessHeap(), 0, sizeof(*face));
         face->cached_enum_data = NULL;
         face->family = NULL;
@@ -1662,15 +1658,13 @@ static void load_face(HKEY hkey_face, WCHAR *face_name, Family *family, void *bu
         else
             face->FullName = NULL;
 
-        reg_load_ftlong(hkey_face, face_index_value, &face->face_index);
-        reg_load_dword(hkey_face, face_ntmflags_value, &face->ntmFlags);
-        reg_load_ftlong(hkey_face, face_version_value, &face->font_version);
-        reg_load_dword(hkey_face, face_flags_value, &face->flags);
-
-        needed = sizeof(face->fs);
-        RegQueryValueExW(hkey_face, face_font_sig_value, NULL, NULL, (BYTE*)&face->fs, &needed);
+        face->face_index = data.index;
+        face->ntmFlags = data.ntmflags;
+        face->font_version = data.version;
+        face->flags = data.flags;
+        face->fs = data.fs;
 
-        if(reg_load_ftshort(hkey_face, face_height_value, &face->size.height) != ERROR_SUCCESS)
+        if (data.scalable)
         {
             face->scalable = TRUE;
             memset(&face->size, 0, sizeof(face->size));
@@ -1678,11 +1672,12 @@ static void load_face(HKEY hkey_face, WCHAR *face_name, Family *family, void *bu
         else
         {
             face->scalable = FALSE;
-            reg_load_ftshort(hkey_face, face_width_value, &face->size.width);
-            reg_load_ftlong(hkey_face, face_size_value, &face->size.size);
-            reg_load_ftlong(hkey_face, face_x_ppem_value, &face->size.x_ppem);
-            reg_load_ftlong(hkey_face, face_y_ppem_value, &face->size.y_ppem);
-            reg_load_ftshort(hkey_face, face_internal_leading_value, &face->size.internal_leading);
+            face->size.height = data.height;
+            face->size.width = data.width;
+            face->size.size = data.size;
+            face->size.x_ppem = data.x_ppem;
+            face->size.y_ppem = data.y_ppem;
+            face->size.internal_leading = data.internal_leading;
 
             TRACE("Adding bitmap size h %d w %d size %ld x_ppem %ld y_ppem %ld\n",
                   face->size.height, face->size.width, face->size.size >> 6,
@@ -1700,6 +1695,7 @@ static void load_face(HKEY hkey_face, WCHAR *face_name, Family *family, void *bu
         release_face( face );
     }
 
+strikes:
     /* load bitmap strikes */
 
     needed = buffer_size;
@@ -1822,6 +1818,7 @@ static LONG create_font_cache_key(HKEY *hkey, DWORD *disposition)
 
 static void add_face_to_cache(Face *face)
 {
+    struct cached_face_data data;
     HKEY hkey_family, hkey_face;
     WCHAR *face_key_name;
 
@@ -1850,22 +1847,23 @@ static void add_face_to_cache(Face *face)
         RegSetValueExW(hkey_face, face_full_name_value, 0, REG_SZ, (BYTE*)face->FullName,
                        (strlenW(face->FullName) + 1) * sizeof(WCHAR));
 
-    reg_save_dword(hkey_face, face_index_value, face->face_index);
-    reg_save_dword(hkey_face, face_ntmflags_value, face->ntmFlags);
-    reg_save_dword(hkey_face, face_version_value, face->font_version);
-    if (face->flags) reg_save_dword(hkey_face, face_flags_value, face->flags);
-
-    RegSetValueExW(hkey_face, face_font_sig_value, 0, REG_BINARY, (BYTE*)&face->fs, sizeof(face->fs));
-
+    memset(&data, 0, sizeof(data));
+    data.index = face->face_index;
+    data.ntmflags = face->ntmFlags;
+    data.version = face->font_version;
+    data.flags = face->flags;
+    data.fs = face->fs;
+    data.scalable = face->scalable;
     if(!face->scalable)
     {
-        reg_save_dword(hkey_face, face_height_value, face->size.height);
-        reg_save_dword(hkey_face, face_width_value, face->size.width);
-        reg_save_dword(hkey_face, face_size_value, face->size.size);
-        reg_save_dword(hkey_face, face_x_ppem_value, face->size.x_ppem);
-        reg_save_dword(hkey_face, face_y_ppem_value, face->size.y_ppem);
-        reg_save_dword(hkey_face, face_internal_leading_value, face->size.internal_leading);
+        data.height = face->size.height;
+        data.width = face->size.width;
+        data.size = face->size.size;
+        data.x_ppem = face->size.x_ppem;
+        data.y_ppem = face->size.y_ppem;
+        data.internal_leading = face->size.internal_leading;
     }
+    RegSetValueExW(hkey_face, face_data_value, 0, REG_BINARY, (BYTE *)&data, sizeof(data));
     RegCloseKey(hkey_face);
     RegCloseKey(hkey_family);
 }
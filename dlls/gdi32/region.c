@@ -1062,32 +1062,46 @@ BOOL WINAPI RectInRegion( HRGN hrgn, const RECT *rect )
     WINEREGION *obj;
     BOOL ret = FALSE;
     RECT rc;
-    int i;
+    int i, y;
 
     /* swap the coordinates to make right >= left and bottom >= top */
     /* (region building rectangles are normalized the same way) */
     rc = *rect;
     order_rect( &rc );
+    y = rc.top;
 
     if ((obj = GDI_GetObjPtr( hrgn, OBJ_REGION )))
     {
 	if ((obj->numRects > 0) && overlapping(&obj->extents, &rc))
 	{
-	    for (i = region_find_pt( obj, rc.left, rc.top, &ret ); !ret && i < obj->numRects; i++ )
+	    /* walk the bands covered by the rectangle, using a binary search to
+	     * find the first candidate of each band instead of scanning every
+	     * rectangle on the way */
+	    for (i = region_find_pt( obj, rc.left, rc.top, &ret ); !ret && i < obj->numRects;)
 	    {
-	        if (obj->rects[i].bottom <= rc.top)
-		    continue;             /* not far enough down yet */
+		const RECT *cur = &obj->rects[i];
 
-		if (obj->rects[i].top >= rc.bottom)
+		if (cur->top >= rc.bottom)
 		    break;                /* too far down */
 
-		if (obj->rects[i].right <= rc.left)
-		    continue;              /* not far enough over yet */
-
-		if (obj->rects[i].left >= rc.right)
+		if (cur->top > y)
+		{
+		    /* start of a new band, skip the rectangles left of rc */
+		    y = cur->top;
+		    i = region_find_pt( obj, rc.left, y, NULL );
 		    continue;
+		}
+
+		/* cur is the first rectangle of the band with right > rc.left */
+		if (cur->left < rc.right)
+		{
+		    ret = TRUE;
+		    break;
+		}
 
-		ret = TRUE;
+		/* the remaining rectangles of the band are too far over */
+		y = cur->bottom;
+		i = region_find_pt( obj, rc.left, y, NULL );
 	    }
 	}
 	GDI_ReleaseObj(hrgn);
@@ -1590,6 +1604,47 @@ static INT REGION_Coalesce (
     return (curStart);
 }
 
+/* The array of the previous contents of the destination of a region operation
+ * is kept around, so that the next operation can use it instead of allocating
+ * a new one. Its size in rectangles is stored in its first entry. */
+#define RGN_MAX_SPARE_RECTS 4096
+static RECT *spare_rects;
+
+/**********************************************************************
+ *          get_spare_rects
+ *
+ * Take the spare array of rectangles if it holds at least n rectangles.
+ */
+static RECT *get_spare_rects( INT n, INT *size )
+{
+    RECT *rects;
+
+    if (n <= RGN_DEFAULT_RECTS || n > RGN_MAX_SPARE_RECTS) return NULL;
+    if (!(rects = InterlockedExchangePointer( (void **)&spare_rects, NULL ))) return NULL;
+    if (rects->left < n)
+    {
+        HeapFree( GetProcessHeap(), 0, rects );
+        return NULL;
+    }
+    *size = rects->left;
+    return rects;
+}
+
+/**********************************************************************
+ *          put_spare_rects
+ *
+ * Keep an array of rectangles for the next region operation, or free it.
+ */
+static void put_spare_rects( RECT *rects, INT size )
+{
+    if (size <= RGN_MAX_SPARE_RECTS)
+    {
+        rects->left = size;
+        rects = InterlockedExchangePointer( (void **)&spare_rects, rects );
+    }
+    HeapFree( GetProcessHeap(), 0, rects );
+}
+
 /**********************************************************************
  *          REGION_compact
  *
@@ -1660,6 +1715,7 @@ static BOOL REGION_RegionOp(
     RECT *r2BandEnd;                  /* End of current band in r2 */
     INT top;                          /* Top of non-overlapping band */
     INT bot;                          /* Bottom of non-overlapping band */
+    INT size;                         /* Initial size of newReg */
 
     /*
      * Initialization:
@@ -1680,7 +1736,12 @@ static BOOL REGION_RegionOp(
      * have to worry about using too much memory. I hope to be able to
      * nuke the Xrealloc() at the end of this function eventually.
      */
-    if (!init_region( &newReg, max(reg1->numRects,reg2->numRects) * 2 )) return FALSE;
+    size = max(reg1->numRects,reg2->numRects) * 2;
+    if (!(newReg.rects = get_spare_rects( size, &newReg.size )))
+    {
+        if (!init_region( &newReg, size )) return FALSE;
+    }
+    else empty_region( &newReg );
 
     /*
      * Initialize ybot and ytop.
@@ -1749,7 +1810,7 @@ static BOOL REGION_RegionOp(
 
             if ((top != bot) && (nonOverlap1Func != NULL))
 	    {
-		if (!nonOverlap1Func(&newReg, r1, r1BandEnd, top, bot)) return FALSE;
+		if (!nonOverlap1Func(&newReg, r1, r1BandEnd, top, bot)) goto fail;
 	    }
 
 	    ytop = r2->top;
@@ -1761,7 +1822,7 @@ static BOOL REGION_RegionOp(
 
             if ((top != bot) && (nonOverlap2Func != NULL))
 	    {
-		if (!nonOverlap2Func(&newReg, r2, r2BandEnd, top, bot)) return FALSE;
+		if (!nonOverlap2Func(&newReg, r2, r2BandEnd, top, bot)) goto fail;
 	    }
 
 	    ytop = r1->top;
@@ -1790,7 +1851,7 @@ static BOOL REGION_RegionOp(
 	curBand = newReg.numRects;
 	if (ybot > ytop)
 	{
-	    if (!overlapFunc(&newReg, r1, r1BandEnd, r2, r2BandEnd, ytop, ybot)) return FALSE;
+	    if (!overlapFunc(&newReg, r1, r1BandEnd, r2, r2BandEnd, ytop, ybot)) goto fail;
 	}
 
 	if (newReg.numRects != curBand)
@@ -1828,7 +1889,7 @@ static BOOL REGION_RegionOp(
 		    r1BandEnd++;
 		}
 		if (!nonOverlap1Func(&newReg, r1, r1BandEnd, max(r1->top,ybot), r1->bottom))
-                    return FALSE;
+                    goto fail;
 		r1 = r1BandEnd;
 	    } while (r1 != r1End);
 	}
@@ -1843,7 +1904,7 @@ static BOOL REGION_RegionOp(
 		 r2BandEnd++;
 	    }
 	    if (!nonOverlap2Func(&newReg, r2, r2BandEnd, max(r2->top,ybot), r2->bottom))
-                return FALSE;
+                goto fail;
 	    r2 = r2BandEnd;
 	} while (r2 != r2End);
     }
@@ -1854,8 +1915,17 @@ static BOOL REGION_RegionOp(
     }
 
     REGION_compact( &newReg );
+    if (destReg->rects != destReg->rects_buf)
+    {
+        put_spare_rects( destReg->rects, destReg->size );
+        destReg->rects = destReg->rects_buf;
+    }
     move_rects( destReg, &newReg );
     return TRUE;
+
+fail:
+    destroy_region( &newReg );
+    return FALSE;
 }
 
 /***********************************************************************
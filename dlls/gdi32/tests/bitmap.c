@@ -3959,6 +3959,104 @@ static void test_GdiGradientFill(void)
     HeapFree(GetProcessHeap(), 0, bmi);
 }
 
+static void test_large_blend_and_gradient(void)
+{
+    static const int width = 1024, height = 512;
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 0xff, AC_SRC_ALPHA };
+    GRADIENT_RECT rect = { 0, 1 };
+    TRIVERTEX vt[2] = { { 0, 0, 0xff00, 0x1000, 0x0000, 0x8000 },
+                        { 0, 0, 0x0000, 0xff00, 0x4000, 0xff00 } };
+    HDC hdc_dst, hdc_src;
+    HBITMAP bmp_dst, bmp_src;
+    BITMAPINFO *bmi;
+    DWORD *dst_bits, *src_bits, *ref;
+    HRGN rgn;
+    BOOL ret;
+    int x, y;
+
+    if (!pGdiAlphaBlend || !pGdiGradientFill)
+    {
+        win_skip( "GdiAlphaBlend or GdiGradientFill is not available\n" );
+        return;
+    }
+
+    /* large operations may be split into bands, check that the result
+     * matches the one of single rows */
+    hdc_dst = CreateCompatibleDC( NULL );
+    hdc_src = CreateCompatibleDC( NULL );
+    bmi = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(BITMAPINFO) );
+    bmi->bmiHeader.biSize = sizeof(bmi->bmiHeader);
+    bmi->bmiHeader.biWidth = width;
+    bmi->bmiHeader.biHeight = -height;
+    bmi->bmiHeader.biPlanes = 1;
+    bmi->bmiHeader.biBitCount = 32;
+    bmi->bmiHeader.biCompression = BI_RGB;
+    bmp_src = CreateDIBSection( hdc_src, bmi, DIB_RGB_COLORS, (void **)&src_bits, NULL, 0 );
+    ok( bmp_src != NULL, "couldn't create bitmap\n" );
+    SelectObject( hdc_src, bmp_src );
+    bmp_dst = CreateDIBSection( hdc_dst, bmi, DIB_RGB_COLORS, (void **)&dst_bits, NULL, 0 );
+    ok( bmp_dst != NULL, "couldn't create bitmap\n" );
+    SelectObject( hdc_dst, bmp_dst );
+    ref = HeapAlloc( GetProcessHeap(), 0, width * height * sizeof(DWORD) );
+
+    for (y = 0; y < height; y++)
+    {
+        for (x = 0; x < width; x++)
+        {
+            BYTE a = x * 7 + y * 3;
+            src_bits[y * width + x] = (a << 24) | ((a * (x & 0xff) / 255) << 16) |
+                                      ((a * (y & 0xff) / 255) << 8) | (a / 2);
+        }
+    }
+
+    for (x = 0; x < width * height; x++) dst_bits[x] = (DWORD)x * 0x01030507;
+    ret = pGdiAlphaBlend( hdc_dst, 0, 0, width, height, hdc_src, 0, 0, width, height, blend );
+    ok( ret, "GdiAlphaBlend failed err %u\n", GetLastError() );
+    memcpy( ref, dst_bits, width * height * sizeof(DWORD) );
+
+    for (x = 0; x < width * height; x++) dst_bits[x] = (DWORD)x * 0x01030507;
+    for (y = 0; y < height; y++)
+    {
+        ret = pGdiAlphaBlend( hdc_dst, 0, y, width, 1, hdc_src, 0, y, width, 1, blend );
+        ok( ret, "GdiAlphaBlend failed err %u\n", GetLastError() );
+    }
+    ok( !memcmp( ref, dst_bits, width * height * sizeof(DWORD) ), "AlphaBlend results differ\n" );
+
+    /* use a 16-bpp destination for gradients, so that dithering is involved */
+    DeleteDC( hdc_dst );
+    DeleteObject( bmp_dst );
+    hdc_dst = CreateCompatibleDC( NULL );
+    bmi->bmiHeader.biBitCount = 16;
+    bmp_dst = CreateDIBSection( hdc_dst, bmi, DIB_RGB_COLORS, (void **)&dst_bits, NULL, 0 );
+    ok( bmp_dst != NULL, "couldn't create bitmap\n" );
+    SelectObject( hdc_dst, bmp_dst );
+    vt[1].x = width;
+    vt[1].y = height;
+
+    ret = pGdiGradientFill( hdc_dst, vt, 2, &rect, 1, GRADIENT_FILL_RECT_H );
+    ok( ret, "GdiGradientFill failed err %u\n", GetLastError() );
+    memcpy( ref, dst_bits, width * height * sizeof(WORD) );
+
+    memset( dst_bits, 0, width * height * sizeof(WORD) );
+    for (y = 0; y < height; y++)
+    {
+        rgn = CreateRectRgn( 0, y, width, y + 1 );
+        SelectClipRgn( hdc_dst, rgn );
+        DeleteObject( rgn );
+        ret = pGdiGradientFill( hdc_dst, vt, 2, &rect, 1, GRADIENT_FILL_RECT_H );
+        ok( ret, "GdiGradientFill failed err %u\n", GetLastError() );
+    }
+    SelectClipRgn( hdc_dst, NULL );
+    ok( !memcmp( ref, dst_bits, width * height * sizeof(WORD) ), "GradientFill results differ\n" );
+
+    DeleteDC( hdc_dst );
+    DeleteDC( hdc_src );
+    DeleteObject( bmp_dst );
+    DeleteObject( bmp_src );
+    HeapFree( GetProcessHeap(), 0, ref );
+    HeapFree( GetProcessHeap(), 0, bmi );
+}
+
 static void test_clipping(void)
 {
     HBITMAP bmpDst;
@@ -5981,6 +6079,7 @@ START_TEST(bitmap)
     test_StretchDIBits();
     test_GdiAlphaBlend();
     test_GdiGradientFill();
+    test_large_blend_and_gradient();
     test_32bit_ddb();
     test_bitmapinfoheadersize();
     test_get16dibits();
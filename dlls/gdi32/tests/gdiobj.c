@@ -282,9 +282,36 @@ static void test_GetCurrentObject(void)
 
 static void test_region(void)
 {
-    HRGN hrgn = CreateRectRgn(10, 10, 20, 20);
+    static const RECT band_rects[] =
+    {
+        { 10, 10, 20, 20 }, { 30, 10, 40, 20 },
+        { 50, 30, 60, 40 },
+        { 0, 50, 10, 60 }, { 70, 50, 80, 60 },
+    };
+    static const struct
+    {
+        RECT rect;
+        BOOL expect;
+    } band_tests[] =
+    {
+        { { 21, 11, 29, 19 }, FALSE },
+        { { 21, 11, 31, 19 }, TRUE },
+        { { 0, 21, 100, 29 }, FALSE },
+        { { 0, 15, 9, 45 }, FALSE },
+        { { 41, 0, 49, 100 }, FALSE },
+        { { 41, 0, 51, 100 }, TRUE },
+        { { 15, 25, 55, 28 }, FALSE },
+        { { 11, 35, 71, 55 }, TRUE },
+        { { 11, 41, 69, 49 }, FALSE },
+        { { 11, 41, 69, 51 }, FALSE },
+        { { 11, 41, 71, 51 }, TRUE },
+        { { 80, 50, 90, 60 }, FALSE },
+        { { 5, 55, 6, 56 }, TRUE },
+    };
+    HRGN hrgn = CreateRectRgn(10, 10, 20, 20), hrgn2, hrgn3, tmp_rgn;
     RECT rc = { 5, 5, 15, 15 };
     BOOL ret = RectInRegion( hrgn, &rc);
+    unsigned int i;
     ok( ret, "RectInRegion should return TRUE\n");
     /* swap left and right */
     SetRect( &rc, 15, 5, 5, 15 );
@@ -317,6 +344,40 @@ static void test_region(void)
     ret = RectInRegion( hrgn, &rc);
     ok( ret, "RectInRegion should return TRUE\n");
     DeleteObject(hrgn);
+
+    /* several bands with gaps between them and between their rectangles */
+    hrgn = CreateRectRgn(0, 0, 0, 0);
+    for (i = 0; i < ARRAY_SIZE(band_rects); i++)
+    {
+        HRGN tmp = CreateRectRgnIndirect( &band_rects[i] );
+        CombineRgn( hrgn, hrgn, tmp, RGN_OR );
+        DeleteObject( tmp );
+    }
+    for (i = 0; i < ARRAY_SIZE(band_tests); i++)
+    {
+        ret = RectInRegion( hrgn, &band_tests[i].rect );
+        ok( ret == band_tests[i].expect, "%u: RectInRegion returned %d\n", i, ret );
+    }
+
+    /* combine into a region that already holds more rectangles than needed */
+    hrgn2 = CreateRectRgn(0, 0, 0, 0);
+    hrgn3 = CreateRectRgn(0, 0, 0, 0);
+    for (i = 0; i < 20; i++)
+    {
+        HRGN tmp = CreateRectRgn( i * 10, i * 10, i * 10 + 5, i * 10 + 5 );
+        CombineRgn( hrgn2, hrgn2, tmp, RGN_OR );
+        DeleteObject( tmp );
+    }
+    tmp_rgn = CreateRectRgn( 5, 5, 35, 35 );
+    ret = CombineRgn( hrgn3, hrgn, tmp_rgn, RGN_XOR );
+    ok( ret == COMPLEXREGION, "CombineRgn returned %d\n", ret );
+    ret = CombineRgn( hrgn2, hrgn, tmp_rgn, RGN_XOR );
+    ok( ret == COMPLEXREGION, "CombineRgn returned %d\n", ret );
+    ok( EqualRgn( hrgn2, hrgn3 ), "regions differ\n" );
+    DeleteObject( tmp_rgn );
+    DeleteObject( hrgn3 );
+    DeleteObject( hrgn2 );
+    DeleteObject( hrgn );
 }
 
 static void test_handles_on_win64(void)
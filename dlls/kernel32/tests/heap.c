@@ -842,8 +842,11 @@ static void test_obsolete_flags(void)
 
 static void test_HeapQueryInformation(void)
 {
+    void *ptrs[64];
+    HANDLE heap;
     ULONG info;
     SIZE_T size;
+    unsigned int i;
     BOOL ret;
 
     pHeapQueryInformation = (void *)GetProcAddress(GetModuleHandleA("kernel32.dll"), "HeapQueryInformation");
@@ -890,6 +893,87 @@ static void test_HeapQueryInformation(void)
                                 &info, sizeof(info) + 1, NULL);
     ok(ret, "HeapQueryInformation error %u\n", GetLastError());
     ok(info == 0 || info == 1 || info == 2, "expected 0, 1 or 2, got %u\n", info);
+
+    heap = HeapCreate(0, 0, 0);
+    ok(heap != NULL, "HeapCreate error %u\n", GetLastError());
+    info = 2;
+    ret = HeapSetInformation(heap, HeapCompatibilityInformation, &info, sizeof(info));
+    ok(ret, "HeapSetInformation error %u\n", GetLastError());
+    info = 0xdeadbeef;
+    ret = pHeapQueryInformation(heap, HeapCompatibilityInformation, &info, sizeof(info), NULL);
+    ok(ret, "HeapQueryInformation error %u\n", GetLastError());
+    ok(info == 2, "expected 2, got %u\n", info);
+
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        ptrs[i] = HeapAlloc(heap, 0, 8 + 3 * i);
+        ok(ptrs[i] != NULL, "HeapAlloc failed for size %u\n", 8 + 3 * i);
+        memset(ptrs[i], 0xcc, 8 + 3 * i);
+    }
+    for (i = 0; i < ARRAY_SIZE(ptrs); i += 2)
+    {
+        ret = HeapFree(heap, 0, ptrs[i]);
+        ok(ret, "HeapFree failed for %p\n", ptrs[i]);
+    }
+    for (i = 0; i < ARRAY_SIZE(ptrs); i += 2)
+    {
+        ptrs[i] = HeapAlloc(heap, HEAP_ZERO_MEMORY, 8 + 3 * i);
+        ok(ptrs[i] != NULL, "HeapAlloc failed for size %u\n", 8 + 3 * i);
+        ok(!*(BYTE *)ptrs[i], "memory not zeroed\n");
+    }
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        size = HeapSize(heap, 0, ptrs[i]);
+        ok(size == 8 + 3 * i, "expected %u, got %lu\n", 8 + 3 * i, size);
+    }
+
+    /* blocks that don't belong to the heap must not be cached by the front end,
+     * Windows may raise a heap corruption exception for these */
+    if (!strcmp(winetest_platform, "wine"))
+    {
+        DWORD_PTR bogus[8];
+        HANDLE heap2;
+        void *ptr;
+
+        heap2 = HeapCreate(0, 0, 0);
+        ok(heap2 != NULL, "HeapCreate error %u\n", GetLastError());
+        info = 2;
+        ret = HeapSetInformation(heap2, HeapCompatibilityInformation, &info, sizeof(info));
+        ok(ret, "HeapSetInformation error %u\n", GetLastError());
+        ptr = HeapAlloc(heap2, 0, 16);
+        ok(ptr != NULL, "HeapAlloc failed\n");
+
+        SetLastError(0xdeadbeef);
+        ret = HeapFree(heap, 0, ptr);
+        ok(!ret, "HeapFree succeeded for a block of another heap\n");
+        ok(GetLastError() == ERROR_INVALID_PARAMETER, "got error %u\n", GetLastError());
+        ok(HeapAlloc(heap, 0, 16) != ptr, "HeapAlloc returned a block of another heap\n");
+
+        memset(bogus, 0, sizeof(bogus));
+        ret = HeapFree(heap, 0, bogus + 4);
+        ok(!ret, "HeapFree succeeded for a stack pointer\n");
+        ret = HeapFree(heap, 0, (void *)0xdeadbee0);
+        ok(!ret, "HeapFree succeeded for a bogus pointer\n");
+
+        ret = HeapFree(heap2, 0, ptr);
+        ok(ret, "HeapFree failed\n");
+        HeapDestroy(heap2);
+    }
+    ok(HeapValidate(heap, 0, NULL), "HeapValidate failed\n");
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++) HeapFree(heap, 0, ptrs[i]);
+    ok(HeapValidate(heap, 0, NULL), "HeapValidate failed\n");
+    HeapDestroy(heap);
+
+    heap = HeapCreate(HEAP_NO_SERIALIZE, 0, 0);
+    ok(heap != NULL, "HeapCreate error %u\n", GetLastError());
+    info = 2;
+    ret = HeapSetInformation(heap, HeapCompatibilityInformation, &info, sizeof(info));
+    ok(!ret, "HeapSetInformation succeeded\n");
+    info = 0xdeadbeef;
+    ret = pHeapQueryInformation(heap, HeapCompatibilityInformation, &info, sizeof(info), NULL);
+    ok(ret, "HeapQueryInformation error %u\n", GetLastError());
+    ok(info == 0, "expected 0, got %u\n", info);
+    HeapDestroy(heap);
 }
 
 static void test_heap_checks( DWORD flags )
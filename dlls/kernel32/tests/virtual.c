@@ -50,6 +50,7 @@ static NTSTATUS (WINAPI *pNtQuerySection)(HANDLE, SECTION_INFORMATION_CLASS, voi
 static PVOID  (WINAPI *pRtlAddVectoredExceptionHandler)(ULONG, PVECTORED_EXCEPTION_HANDLER);
 static ULONG  (WINAPI *pRtlRemoveVectoredExceptionHandler)(PVOID);
 static BOOL   (WINAPI *pGetProcessDEPPolicy)(HANDLE, LPDWORD, PBOOL);
+static SIZE_T (WINAPI *pGetLargePageMinimum)(void);
 static BOOL   (WINAPI *pIsWow64Process)(HANDLE, PBOOL);
 static NTSTATUS (WINAPI *pNtProtectVirtualMemory)(HANDLE, PVOID *, SIZE_T *, ULONG, ULONG *);
 static NTSTATUS (WINAPI *pNtAllocateVirtualMemory)(HANDLE, PVOID *, ULONG, SIZE_T *, ULONG, ULONG);
@@ -471,6 +472,75 @@ static void test_VirtualAlloc(void)
     ok(VirtualFree(addr1, 0, MEM_RELEASE), "VirtualFree failed\n");
 }
 
+static void test_VirtualAlloc_large_pages(void)
+{
+    MEMORY_BASIC_INFORMATION info;
+    TOKEN_PRIVILEGES privs;
+    SIZE_T large_page;
+    HANDLE token;
+    void *addr;
+    BOOL ret;
+
+    if (!pGetLargePageMinimum || !(large_page = pGetLargePageMinimum()))
+    {
+        win_skip("large pages are not supported\n");
+        return;
+    }
+
+    SetLastError(0xdeadbeef);
+    addr = VirtualAlloc(NULL, large_page, MEM_LARGE_PAGES | MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    ok(!addr, "VirtualAlloc succeeded\n");
+    ok(GetLastError() == ERROR_PRIVILEGE_NOT_HELD, "got error %u\n", GetLastError());
+
+    privs.PrivilegeCount = 1;
+    privs.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES, &token) ||
+        !LookupPrivilegeValueA(NULL, SE_LOCK_MEMORY_NAME, &privs.Privileges[0].Luid) ||
+        !AdjustTokenPrivileges(token, FALSE, &privs, sizeof(privs), NULL, NULL) ||
+        GetLastError() == ERROR_NOT_ALL_ASSIGNED)
+    {
+        win_skip("cannot enable SE_LOCK_MEMORY_NAME privilege\n");
+        CloseHandle(token);
+        return;
+    }
+
+    SetLastError(0xdeadbeef);
+    addr = VirtualAlloc(NULL, large_page, MEM_LARGE_PAGES | MEM_RESERVE, PAGE_READWRITE);
+    ok(!addr, "VirtualAlloc succeeded\n");
+    ok(GetLastError() == ERROR_INVALID_PARAMETER, "got error %u\n", GetLastError());
+
+    SetLastError(0xdeadbeef);
+    addr = VirtualAlloc(NULL, large_page, MEM_LARGE_PAGES | MEM_COMMIT, PAGE_READWRITE);
+    ok(!addr, "VirtualAlloc succeeded\n");
+    ok(GetLastError() == ERROR_INVALID_PARAMETER, "got error %u\n", GetLastError());
+
+    SetLastError(0xdeadbeef);
+    addr = VirtualAlloc(NULL, large_page + si.dwPageSize, MEM_LARGE_PAGES | MEM_RESERVE | MEM_COMMIT,
+                        PAGE_READWRITE);
+    ok(!addr, "VirtualAlloc succeeded\n");
+    ok(GetLastError() == ERROR_INVALID_PARAMETER, "got error %u\n", GetLastError());
+
+    SetLastError(0xdeadbeef);
+    addr = VirtualAlloc(NULL, large_page, MEM_LARGE_PAGES | MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    ok(addr != NULL || broken(GetLastError() == ERROR_NO_SYSTEM_RESOURCES), /* no free large pages */
+       "VirtualAlloc failed, error %u\n", GetLastError());
+    if (addr)
+    {
+        ok(!((UINT_PTR)addr & (large_page - 1)), "address %p is not aligned\n", addr);
+        memset(addr, 0xcc, large_page);
+        ret = VirtualQuery(addr, &info, sizeof(info));
+        ok(ret, "VirtualQuery failed\n");
+        ok(info.State == MEM_COMMIT, "got state %#x\n", info.State);
+        ok(info.RegionSize == large_page, "got size %#lx\n", info.RegionSize);
+        ret = VirtualFree(addr, 0, MEM_RELEASE);
+        ok(ret, "VirtualFree failed, error %u\n", GetLastError());
+    }
+
+    privs.Privileges[0].Attributes = 0;
+    AdjustTokenPrivileges(token, FALSE, &privs, sizeof(privs), NULL, NULL);
+    CloseHandle(token);
+}
+
 static void test_MapViewOfFile(void)
 {
     static const char testfile[] = "testfile.xxx";
@@ -4361,6 +4431,7 @@ START_TEST(virtual)
     pGetWriteWatch = (void *) GetProcAddress(hkernel32, "GetWriteWatch");
     pResetWriteWatch = (void *) GetProcAddress(hkernel32, "ResetWriteWatch");
     pGetProcessDEPPolicy = (void *)GetProcAddress( hkernel32, "GetProcessDEPPolicy" );
+    pGetLargePageMinimum = (void *)GetProcAddress( hkernel32, "GetLargePageMinimum" );
     pIsWow64Process = (void *)GetProcAddress( hkernel32, "IsWow64Process" );
     pNtAreMappedFilesTheSame = (void *)GetProcAddress( hntdll, "NtAreMappedFilesTheSame" );
     pNtCreateSection = (void *)GetProcAddress( hntdll, "NtCreateSection" );
@@ -4386,6 +4457,7 @@ START_TEST(virtual)
     test_VirtualProtect();
     test_VirtualAllocEx();
     test_VirtualAlloc();
+    test_VirtualAlloc_large_pages();
     test_MapViewOfFile();
     test_NtMapViewOfSection();
     test_NtAreMappedFilesTheSame();
@@ -199,6 +199,28 @@ static const unsigned int dir_data_names_initial_size  = 64;
 static struct dir_data **dir_data_cache;
 static unsigned int dir_data_cache_size;
 
+struct dir_lookup_entry
+{
+    unsigned int hash;               /* case-insensitive hash of the Unicode name */
+    unsigned int offset;             /* offset of the Unix name in the names buffer */
+};
+
+struct dir_lookup_names
+{
+    struct file_identity     id;         /* directory file identity */
+    time_t                   mtime;      /* directory modification time */
+    unsigned long            mtime_nsec;
+    unsigned int             count;      /* count of entries */
+    unsigned int             hash_size;  /* size of the hash table, a power of 2 */
+    unsigned int            *hash;       /* hash table of entry indices + 1 */
+    struct dir_lookup_entry *entries;    /* directory entries in readdir order */
+    char                    *buffer;     /* Unix names in host encoding */
+};
+
+/* cache of recently searched directories for case-insensitive lookups */
+static struct dir_lookup_names *dir_lookup_cache[4];
+static unsigned int dir_lookup_next;
+
 static BOOL show_dot_files;
 static RTL_RUN_ONCE init_once = RTL_RUN_ONCE_INIT;
 
@@ -1499,6 +1521,16 @@ static NTSTATUS get_dir_data_entry( struct dir_data *dir_data, void *info_ptr, I
     struct stat st;
     ULONG name_len, start, dir_size, attributes;
 
+    /* check for space first, so that an entry that doesn't fit isn't stat'ed twice */
+    start = dir_info_align( io->Information );
+    dir_size = dir_info_size( class, 0 );
+    if (start + dir_size > max_length) return STATUS_MORE_ENTRIES;
+
+    max_length -= start + dir_size;
+    name_len = strlenW( names->long_name ) * sizeof(WCHAR);
+    /* if this is not the first entry, fail; the first entry is always returned (but truncated) */
+    if (*last_info && name_len > max_length) return STATUS_MORE_ENTRIES;
+
     if (get_file_info( names->unix_name, &st, &attributes ) == -1)
     {
         TRACE( "file no longer exists %s\n", names->unix_name );
@@ -1509,14 +1541,6 @@ static NTSTATUS get_dir_data_entry( struct dir_data *dir_data, void *info_ptr, I
         TRACE( "ignoring file %s\n", names->unix_name );
         return STATUS_SUCCESS;
     }
-    start = dir_info_align( io->Information );
-    dir_size = dir_info_size( class, 0 );
-    if (start + dir_size > max_length) return STATUS_MORE_ENTRIES;
-
-    max_length -= start + dir_size;
-    name_len = strlenW( names->long_name ) * sizeof(WCHAR);
-    /* if this is not the first entry, fail; the first entry is always returned (but truncated) */
-    if (*last_info && name_len > max_length) return STATUS_MORE_ENTRIES;
 
     info = (union file_directory_info *)((char *)info_ptr + start);
     info->dir.NextEntryOffset = 0;
@@ -1808,14 +1832,18 @@ static NTSTATUS read_directory_data( struct dir_data *data, int fd, const UNICOD
 
 
 /* compare file names for directory sorting */
+/* same order as RtlCompareUnicodeStrings followed by strcmpW, but in a single pass */
 static int name_compare( const void *a, const void *b )
 {
-    const struct dir_data_names *file_a = (const struct dir_data_names *)a;
-    const struct dir_data_names *file_b = (const struct dir_data_names *)b;
-    int ret = RtlCompareUnicodeStrings( file_a->long_name, strlenW(file_a->long_name),
-                                        file_b->long_name, strlenW(file_b->long_name), TRUE );
-    if (!ret) ret = strcmpW( file_a->long_name, file_b->long_name );
-    return ret;
+    const WCHAR *name_a = ((const struct dir_data_names *)a)->long_name;
+    const WCHAR *name_b = ((const struct dir_data_names *)b)->long_name;
+    const WCHAR *p = name_a, *q = name_b;
+    int ret;
+
+    for ( ; *p && *q; p++, q++) if ((ret = toupperW( *p ) - toupperW( *q ))) return ret;
+    if (*p) return 1;
+    if (*q) return -1;
+    return strcmpW( name_a, name_b );
 }
 
 
@@ -1863,8 +1891,9 @@ static NTSTATUS init_cached_dir_data( struct dir_data **data_ret, int fd, const
     }
 
     TRACE( "mask %s found %u files\n", debugstr_us( mask ), data->count );
-    for (i = 0; i < data->count; i++)
-        TRACE( "%s %s\n", debugstr_w(data->names[i].long_name), debugstr_w(data->names[i].short_name) );
+    if (TRACE_ON(file))
+        for (i = 0; i < data->count; i++)
+            TRACE( "%s %s\n", debugstr_w(data->names[i].long_name), debugstr_w(data->names[i].short_name) );
 
     *data_ret = data;
     return data->count ? STATUS_SUCCESS : STATUS_NO_SUCH_FILE;
@@ -2024,6 +2053,206 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event,
 }
 
 
+/***********************************************************************
+ *           get_stat_mtime_nsec
+ */
+static inline unsigned long get_stat_mtime_nsec( const struct stat *st )
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    return st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    return st->st_mtimespec.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+
+/***********************************************************************
+ *           hash_dir_lookup_name
+ *
+ * Case-insensitive hash of a file name, consistent with memicmpW.
+ */
+static unsigned int hash_dir_lookup_name( const WCHAR *name, int length )
+{
+    unsigned int hash = 0;
+    int i;
+
+    for (i = 0; i < length; i++) hash = hash * 65599 + tolowerW( name[i] );
+    return hash;
+}
+
+
+/***********************************************************************
+ *           free_dir_lookup_names
+ */
+static void free_dir_lookup_names( struct dir_lookup_names *names )
+{
+    if (!names) return;
+    RtlFreeHeap( GetProcessHeap(), 0, names->hash );
+    RtlFreeHeap( GetProcessHeap(), 0, names->entries );
+    RtlFreeHeap( GetProcessHeap(), 0, names->buffer );
+    RtlFreeHeap( GetProcessHeap(), 0, names );
+}
+
+
+/***********************************************************************
+ *           read_dir_lookup_names
+ *
+ * Read all the entries of a directory and build a case-insensitive hash table for them.
+ */
+static struct dir_lookup_names *read_dir_lookup_names( const char *unix_name, const struct stat *st )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN];
+    struct dir_lookup_names *names;
+    struct dir_lookup_entry *new_entries;
+    unsigned int size = 64, buffer_size = 4096, buffer_pos = 0, i, pos, len;
+    char *new_buffer;
+    struct dirent *de;
+    DIR *dir;
+    int ret;
+
+    if (!(dir = opendir( unix_name ))) return NULL;
+
+    if (!(names = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*names) ))) goto error;
+    if (!(names->entries = RtlAllocateHeap( GetProcessHeap(), 0, size * sizeof(*names->entries) )))
+        goto error;
+    if (!(names->buffer = RtlAllocateHeap( GetProcessHeap(), 0, buffer_size ))) goto error;
+
+    while ((de = readdir( dir )))
+    {
+        len = strlen( de->d_name );
+        ret = ntdll_umbstowcs( 0, de->d_name, len, buffer, MAX_DIR_ENTRY_LEN );
+        if (ret <= 0) continue;
+
+        if (names->count == size)
+        {
+            if (!(new_entries = RtlReAllocateHeap( GetProcessHeap(), 0, names->entries,
+                                                   size * 2 * sizeof(*names->entries) )))
+                goto error;
+            names->entries = new_entries;
+            size *= 2;
+        }
+        if (buffer_pos + len + 1 > buffer_size)
+        {
+            while (buffer_pos + len + 1 > buffer_size) buffer_size *= 2;
+            if (!(new_buffer = RtlReAllocateHeap( GetProcessHeap(), 0, names->buffer, buffer_size )))
+                goto error;
+            names->buffer = new_buffer;
+        }
+        memcpy( names->buffer + buffer_pos, de->d_name, len + 1 );
+        names->entries[names->count].hash = hash_dir_lookup_name( buffer, ret );
+        names->entries[names->count].offset = buffer_pos;
+        names->count++;
+        buffer_pos += len + 1;
+    }
+    closedir( dir );
+    dir = NULL;
+
+    for (names->hash_size = 16; names->hash_size < 2 * names->count; names->hash_size *= 2) /* nothing */;
+    if (!(names->hash = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                         names->hash_size * sizeof(*names->hash) )))
+        goto error;
+
+    /* linear probing keeps entries with the same hash in readdir order */
+    for (i = 0; i < names->count; i++)
+    {
+        pos = names->entries[i].hash & (names->hash_size - 1);
+        while (names->hash[pos]) pos = (pos + 1) & (names->hash_size - 1);
+        names->hash[pos] = i + 1;
+    }
+
+    names->id.dev = st->st_dev;
+    names->id.ino = st->st_ino;
+    names->mtime = st->st_mtime;
+    names->mtime_nsec = get_stat_mtime_nsec( st );
+    return names;
+
+error:
+    if (dir) closedir( dir );
+    free_dir_lookup_names( names );
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           lookup_dir_name
+ *
+ * Look for a name in a cached directory. Returns the Unix name or NULL if not found.
+ */
+static const char *lookup_dir_name( const struct dir_lookup_names *names, const WCHAR *name, int length )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN];
+    unsigned int hash = hash_dir_lookup_name( name, length );
+    unsigned int pos, index;
+    const char *unix_name;
+    int ret;
+
+    for (pos = hash & (names->hash_size - 1); (index = names->hash[pos]);
+         pos = (pos + 1) & (names->hash_size - 1))
+    {
+        if (names->entries[index - 1].hash != hash) continue;
+        unix_name = names->buffer + names->entries[index - 1].offset;
+        ret = ntdll_umbstowcs( 0, unix_name, strlen(unix_name), buffer, MAX_DIR_ENTRY_LEN );
+        if (ret == length && !memicmpW( buffer, name, length )) return unix_name;
+    }
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           find_cached_dir_name
+ *
+ * Look for a file name in the cache of recently searched directories, reading
+ * the directory into the cache if needed. The file found is stored in result.
+ * Returns 1 if found, 0 if not found, -1 if the cache can't be used.
+ */
+static int find_cached_dir_name( const char *unix_name, const struct stat *st,
+                                 const WCHAR *name, int length, char *result )
+{
+    struct dir_lookup_names *names, *old = NULL;
+    const char *found;
+    unsigned int i;
+    int ret = -1;
+
+    RtlEnterCriticalSection( &dir_section );
+    for (i = 0; i < ARRAY_SIZE( dir_lookup_cache ); i++)
+    {
+        if (!(names = dir_lookup_cache[i]) || !is_same_file( &names->id, st )) continue;
+        if (names->mtime == st->st_mtime && names->mtime_nsec == get_stat_mtime_nsec( st ))
+        {
+            if ((found = lookup_dir_name( names, name, length ))) strcpy( result, found );
+            ret = (found != NULL);
+        }
+        else  /* directory has been modified */
+        {
+            old = names;
+            dir_lookup_cache[i] = NULL;
+        }
+        break;
+    }
+    RtlLeaveCriticalSection( &dir_section );
+    free_dir_lookup_names( old );
+    if (ret != -1) return ret;
+
+    /* the modification time may not have enough resolution to detect
+     * further changes to a directory that has just been modified */
+    if (st->st_mtime >= time( NULL ) - 1) return -1;
+
+    if (!(names = read_dir_lookup_names( unix_name, st ))) return -1;
+    if ((found = lookup_dir_name( names, name, length ))) strcpy( result, found );
+    ret = (found != NULL);
+
+    RtlEnterCriticalSection( &dir_section );
+    old = dir_lookup_cache[dir_lookup_next];
+    dir_lookup_cache[dir_lookup_next] = names;
+    dir_lookup_next = (dir_lookup_next + 1) % ARRAY_SIZE( dir_lookup_cache );
+    RtlLeaveCriticalSection( &dir_section );
+    free_dir_lookup_names( old );
+    return ret;
+}
+
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -2075,6 +2304,19 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
 
     if (!is_name_8_dot_3 && !get_dir_case_sensitivity( unix_name )) goto not_found;
 
+    /* check the cached directory contents, short names still need a full search */
+
+    if (!stat( unix_name, &st ))
+    {
+        ret = find_cached_dir_name( unix_name, &st, name, length, unix_name + pos );
+        if (ret == 1)
+        {
+            unix_name[pos - 1] = '/';
+            goto success;
+        }
+        if (ret == 0 && !is_name_8_dot_3) goto not_found;
+    }
+
     /* now look for it through the directory */
 
 #ifdef VFAT_IOCTL_READDIR_BOTH
@@ -836,6 +836,7 @@ NTSTATUS WINAPI NtReadFile(HANDLE hFile, HANDLE hEvent,
     enum server_fd_type type;
     ULONG_PTR cvalue = apc ? 0 : (ULONG_PTR)apc_user;
     BOOL send_completion = FALSE, async_read, timeout_init_done = FALSE;
+    HANDLE completion_event = 0;
 
     TRACE("(%p,%p,%p,%p,%p,%p,0x%08x,%p,%p)\n",
           hFile,hEvent,apc,apc_user,io_status,buffer,length,offset,key);
@@ -1003,7 +1004,9 @@ err:
         io_status->u.Status = status;
         io_status->Information = total;
         TRACE("= SUCCESS (%u)\n", total);
-        if (hEvent) NtSetEvent( hEvent, NULL );
+        /* the event is signaled along with the completion to save a server call */
+        if (send_completion) completion_event = hEvent;
+        else if (hEvent) NtSetEvent( hEvent, NULL );
         if (apc && !status) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc,
                                               (ULONG_PTR)apc_user, (ULONG_PTR)io_status, 0 );
     }
@@ -1016,7 +1019,8 @@ err:
     ret_status = async_read && (options & FILE_NO_INTERMEDIATE_BUFFERING) && status == STATUS_SUCCESS
             ? STATUS_PENDING : status;
 
-    if (send_completion) NTDLL_AddCompletion( hFile, cvalue, status, total, ret_status == STATUS_PENDING );
+    if (send_completion)
+        NTDLL_AddCompletion( hFile, cvalue, status, total, ret_status == STATUS_PENDING, completion_event );
     return ret_status;
 }
 
@@ -1087,10 +1091,10 @@ NTSTATUS WINAPI NtReadFileScatter( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
     io_status->u.Status = status;
     io_status->Information = total;
     TRACE("= 0x%08x (%u)\n", status, total);
-    if (event) NtSetEvent( event, NULL );
+    if (event && !send_completion) NtSetEvent( event, NULL );
     if (apc) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc,
                                (ULONG_PTR)apc_user, (ULONG_PTR)io_status, 0 );
-    if (send_completion) NTDLL_AddCompletion( file, cvalue, status, total, TRUE );
+    if (send_completion) NTDLL_AddCompletion( file, cvalue, status, total, TRUE, event );
 
     return STATUS_PENDING;
 
@@ -1204,6 +1208,7 @@ NTSTATUS WINAPI NtWriteFile(HANDLE hFile, HANDLE hEvent,
     enum server_fd_type type;
     ULONG_PTR cvalue = apc ? 0 : (ULONG_PTR)apc_user;
     BOOL send_completion = FALSE, async_write, append_write = FALSE, timeout_init_done = FALSE;
+    HANDLE completion_event = 0;
     LARGE_INTEGER offset_eof;
 
     TRACE("(%p,%p,%p,%p,%p,%p,0x%08x,%p,%p)\n",
@@ -1399,7 +1404,8 @@ err:
         io_status->u.Status = status;
         io_status->Information = total;
         TRACE("= SUCCESS (%u)\n", total);
-        if (hEvent) NtSetEvent( hEvent, NULL );
+        if (send_completion) completion_event = hEvent;
+        else if (hEvent) NtSetEvent( hEvent, NULL );
         if (apc) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc,
                                    (ULONG_PTR)apc_user, (ULONG_PTR)io_status, 0 );
     }
@@ -1409,7 +1415,7 @@ err:
         if (status != STATUS_PENDING && hEvent) NtResetEvent( hEvent, NULL );
     }
 
-    if (send_completion) NTDLL_AddCompletion( hFile, cvalue, status, total, FALSE );
+    if (send_completion) NTDLL_AddCompletion( hFile, cvalue, status, total, FALSE, completion_event );
 
     return status;
 }
@@ -1430,6 +1436,7 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
     enum server_fd_type type;
     ULONG_PTR cvalue = apc ? 0 : (ULONG_PTR)apc_user;
     BOOL send_completion = FALSE;
+    HANDLE completion_event = 0;
 
     TRACE( "(%p,%p,%p,%p,%p,%p,0x%08x,%p,%p),partial stub!\n",
            file, event, apc, apc_user, io_status, segments, length, offset, key);
@@ -1491,7 +1498,8 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         io_status->u.Status = status;
         io_status->Information = total;
         TRACE("= SUCCESS (%u)\n", total);
-        if (event) NtSetEvent( event, NULL );
+        if (send_completion) completion_event = event;
+        else if (event) NtSetEvent( event, NULL );
         if (apc) NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)apc,
                                    (ULONG_PTR)apc_user, (ULONG_PTR)io_status, 0 );
     }
@@ -1501,7 +1509,7 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         if (status != STATUS_PENDING && event) NtResetEvent( event, NULL );
     }
 
-    if (send_completion) NTDLL_AddCompletion( file, cvalue, status, total, FALSE );
+    if (send_completion) NTDLL_AddCompletion( file, cvalue, status, total, FALSE, completion_event );
 
     return status;
 }
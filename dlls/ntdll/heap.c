@@ -83,6 +83,7 @@ typedef struct
 /* Value for arena 'magic' field */
 #define ARENA_INUSE_MAGIC      0x455355
 #define ARENA_PENDING_MAGIC    0xbedead
+#define ARENA_LFH_MAGIC        0x48464c
 #define ARENA_FREE_MAGIC       0x45455246
 #define ARENA_LARGE_MAGIC      0x6752614c
 
@@ -126,6 +127,17 @@ static const SIZE_T HEAP_freeListSizes[] =
 };
 #define HEAP_NB_FREE_LISTS (ARRAY_SIZE( HEAP_freeListSizes ) + HEAP_NB_SMALL_FREE_LISTS)
 
+/* The low fragmentation heap front end keeps freed blocks up to this size
+ * in lock-free lists, one for every arena size */
+#define HEAP_MAX_LFH_BLOCK_SIZE  0x800
+#define HEAP_NB_LFH_BINS  (((HEAP_MAX_LFH_BLOCK_SIZE - HEAP_MIN_DATA_SIZE) / ALIGNMENT) + 1)
+/* max number of bytes kept in a single front end bin */
+#define HEAP_MAX_LFH_BIN_BYTES   0x10000
+
+/* HeapCompatibilityInformation values */
+#define HEAP_STD  0
+#define HEAP_LFH  2
+
 typedef union
 {
     ARENA_FREE  arena;
@@ -164,6 +176,8 @@ typedef struct tagHEAP
     ARENA_INUSE    **pending_free;  /* Ring buffer for pending free requests */
     RTL_CRITICAL_SECTION critSection; /* Critical section for serialization */
     FREE_LIST_ENTRY *freeList;      /* Free lists */
+    DWORD            compat_info;   /* HeapCompatibilityInformation value */
+    SLIST_HEADER    *lfh_bins;      /* Low fragmentation heap front end bins */
 } HEAP;
 
 #define HEAP_MAGIC       ((DWORD)('H' | ('E'<<8) | ('A'<<16) | ('P'<<24)))
@@ -296,7 +310,8 @@ static void subheap_notify_free_all(SUBHEAP const *subheap)
         {
             ARENA_INUSE const *pArena = (ARENA_INUSE const *)ptr;
             if (pArena->magic == ARENA_INUSE_MAGIC) notify_free(pArena + 1);
-            else if (pArena->magic != ARENA_PENDING_MAGIC) ERR("bad inuse_magic @%p\n", pArena);
+            else if (pArena->magic != ARENA_PENDING_MAGIC && pArena->magic != ARENA_LFH_MAGIC)
+                ERR("bad inuse_magic @%p\n", pArena);
             ptr += sizeof(*pArena) + (pArena->size & ARENA_SIZE_MASK);
         }
     }
@@ -870,6 +885,96 @@ static BOOL validate_large_arena( HEAP *heap, const ARENA_LARGE *arena, BOOL qui
 }
 
 
+/***********************************************************************
+ *           lfh_get_bin
+ *
+ * Return the front end bin for a given arena size, or NULL if it is too large.
+ */
+static inline SLIST_HEADER *lfh_get_bin( HEAP *heap, SIZE_T size )
+{
+    if (size > HEAP_MAX_LFH_BLOCK_SIZE) return NULL;
+    return &heap->lfh_bins[(size - HEAP_MIN_DATA_SIZE) / ALIGNMENT];
+}
+
+
+/***********************************************************************
+ *           lfh_alloc_block
+ *
+ * Take a block of the exact rounded size from the front end, without locking the heap.
+ */
+static ARENA_INUSE *lfh_alloc_block( HEAP *heap, SIZE_T rounded_size )
+{
+    SLIST_HEADER *bin;
+    ARENA_INUSE *arena;
+    SLIST_ENTRY *entry;
+
+    if (!(bin = lfh_get_bin( heap, rounded_size ))) return NULL;
+    if (!(entry = RtlInterlockedPopEntrySList( bin ))) return NULL;
+
+    arena = (ARENA_INUSE *)entry - 1;
+    arena->magic = ARENA_INUSE_MAGIC;
+    return arena;
+}
+
+
+/***********************************************************************
+ *           lfh_free_block
+ *
+ * Try to give back an in-use block to the front end.
+ * If the block pointer hasn't been validated yet, the heap isn't locked and
+ * only blocks in the part of the first subheap that is never decommitted are
+ * accepted; anything else, as well as blocks that don't fit in the front end,
+ * goes through the normal validated path.
+ */
+static BOOL lfh_free_block( HEAP *heap, ARENA_INUSE *arena, BOOL validated )
+{
+    const char *start = (const char *)heap->subheap.base + heap->subheap.headerSize;
+    const char *end = (const char *)heap->subheap.base + heap->subheap.min_commit;
+    SLIST_HEADER *bin;
+    DWORD size;
+
+    if (!validated && ((const char *)arena < start || (const char *)(arena + 1) > end)) return FALSE;
+    if ((ULONG_PTR)arena % ALIGNMENT != ARENA_OFFSET) return FALSE;
+    if (arena->magic != ARENA_INUSE_MAGIC) return FALSE;
+    size = arena->size;
+    if (size & ARENA_FLAG_FREE) return FALSE;
+    size &= ARENA_SIZE_MASK;
+    if (!validated && size > end - (const char *)(arena + 1)) return FALSE;
+    if (size < HEAP_MIN_DATA_SIZE || !(bin = lfh_get_bin( heap, size ))) return FALSE;
+    if (RtlQueryDepthSList( bin ) * size >= HEAP_MAX_LFH_BIN_BYTES) return FALSE;
+
+    arena->magic = ARENA_LFH_MAGIC;
+    RtlInterlockedPushEntrySList( bin, (SLIST_ENTRY *)(arena + 1) );
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           lfh_flush_bins
+ *
+ * Give back all the blocks cached in the front end to the heap.
+ * The heap must be locked.
+ */
+static void lfh_flush_bins( HEAP *heap )
+{
+    SLIST_ENTRY *entry, *next;
+    ARENA_INUSE *arena;
+    SUBHEAP *subheap;
+    unsigned int i;
+
+    for (i = 0; i < HEAP_NB_LFH_BINS; i++)
+    {
+        for (entry = RtlInterlockedFlushSList( &heap->lfh_bins[i] ); entry; entry = next)
+        {
+            next = entry->Next;
+            arena = (ARENA_INUSE *)entry - 1;
+            arena->magic = ARENA_INUSE_MAGIC;
+            if ((subheap = HEAP_FindSubHeap( heap, arena ))) HEAP_MakeInUseBlockFree( subheap, arena );
+        }
+    }
+}
+
+
 /***********************************************************************
  *           HEAP_CreateSubHeap
  */
@@ -1214,7 +1319,8 @@ static BOOL HEAP_ValidateInUseArena( const SUBHEAP *subheap, const ARENA_INUSE *
     }
 
     /* Check magic number */
-    if (pArena->magic != ARENA_INUSE_MAGIC && pArena->magic != ARENA_PENDING_MAGIC)
+    if (pArena->magic != ARENA_INUSE_MAGIC && pArena->magic != ARENA_PENDING_MAGIC &&
+        pArena->magic != ARENA_LFH_MAGIC)
     {
         if (quiet == NOISY) {
             ERR("Heap %p: invalid in-use arena magic %08x for %p\n", subheap->heap, pArena->magic, pArena );
@@ -1429,7 +1535,7 @@ static BOOL validate_block_pointer( HEAP *heap, SUBHEAP **ret_subheap, const ARE
         ret = HEAP_ValidateInUseArena( subheap, arena, QUIET );
     else if ((ULONG_PTR)arena % ALIGNMENT != ARENA_OFFSET)
         WARN( "Heap %p: unaligned arena pointer %p\n", subheap->heap, arena );
-    else if (arena->magic == ARENA_PENDING_MAGIC)
+    else if (arena->magic == ARENA_PENDING_MAGIC || arena->magic == ARENA_LFH_MAGIC)
         WARN( "Heap %p: block %p used after free\n", subheap->heap, arena + 1 );
     else if (arena->magic != ARENA_INUSE_MAGIC)
         WARN( "Heap %p: invalid in-use arena magic %08x for %p\n", subheap->heap, arena->magic, arena );
@@ -1638,6 +1744,12 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
         addr = heapPtr->pending_free;
         NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
     }
+    if (heapPtr->lfh_bins)
+    {
+        size = 0;
+        addr = heapPtr->lfh_bins;
+        NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
+    }
     size = 0;
     addr = heapPtr->subheap.base;
     NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
@@ -1683,6 +1795,15 @@ void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_
     }
     if (rounded_size < HEAP_MIN_DATA_SIZE) rounded_size = HEAP_MIN_DATA_SIZE;
 
+    if (heapPtr->lfh_bins && (pInUse = lfh_alloc_block( heapPtr, rounded_size )))
+    {
+        pInUse->unused_bytes = (pInUse->size & ARENA_SIZE_MASK) - size;
+        notify_alloc( pInUse + 1, size, flags & HEAP_ZERO_MEMORY );
+        initialize_block( pInUse + 1, size, pInUse->unused_bytes, flags );
+        TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, pInUse + 1 );
+        return pInUse + 1;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     if (rounded_size >= HEAP_MIN_LARGE_BLOCK_SIZE && (flags & HEAP_GROWABLE))
@@ -1766,18 +1887,25 @@ BOOLEAN WINAPI DECLSPEC_HOTPATCH RtlFreeHeap( HANDLE heap, ULONG flags, void *pt
 
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
+    pInUse  = (ARENA_INUSE *)ptr - 1;
+
+    if (heapPtr->lfh_bins && lfh_free_block( heapPtr, pInUse, FALSE ))
+    {
+        TRACE("(%p,%08x,%p): returning TRUE\n", heap, flags, ptr );
+        return TRUE;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     /* Inform valgrind we are trying to free memory, so it can throw up an error message */
     notify_free( ptr );
 
     /* Some sanity checks */
-    pInUse  = (ARENA_INUSE *)ptr - 1;
     if (!validate_block_pointer( heapPtr, &subheap, pInUse )) goto error;
 
     if (!subheap)
         free_large_block( heapPtr, flags, ptr );
-    else
+    else if (!heapPtr->lfh_bins || !lfh_free_block( heapPtr, pInUse, TRUE ))
         HEAP_MakeInUseBlockFree( subheap, pInUse );
 
     if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
@@ -1953,12 +2081,23 @@ error:
  *  The number of bytes compacted.
  *
  * NOTES
- *  This function is a harmless stub.
+ *  This function only gives back the blocks cached by the low
+ *  fragmentation heap front end.
  */
 ULONG WINAPI RtlCompactHeap( HANDLE heap, ULONG flags )
 {
     static BOOL reported;
-    if (!reported++) FIXME( "(%p, 0x%x) stub\n", heap, flags );
+    HEAP *heapPtr = HEAP_GetPtr( heap );
+
+    if (heapPtr && heapPtr->lfh_bins)
+    {
+        flags &= HEAP_NO_SERIALIZE;
+        flags |= heapPtr->flags;
+        if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
+        lfh_flush_bins( heapPtr );
+        if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
+    }
+    if (!reported++) FIXME( "(%p, 0x%x) semi-stub\n", heap, flags );
     return 0;
 }
 
@@ -2133,7 +2272,8 @@ NTSTATUS WINAPI RtlWalkHeap( HANDLE heap, PVOID entry_ptr )
         }
 
         if (((ARENA_INUSE *)ptr - 1)->magic == ARENA_INUSE_MAGIC ||
-            ((ARENA_INUSE *)ptr - 1)->magic == ARENA_PENDING_MAGIC)
+            ((ARENA_INUSE *)ptr - 1)->magic == ARENA_PENDING_MAGIC ||
+            ((ARENA_INUSE *)ptr - 1)->magic == ARENA_LFH_MAGIC)
         {
             ARENA_INUSE *pArena = (ARENA_INUSE *)ptr - 1;
             ptr += pArena->size & ARENA_SIZE_MASK;
@@ -2181,7 +2321,7 @@ NTSTATUS WINAPI RtlWalkHeap( HANDLE heap, PVOID entry_ptr )
         entry->lpData = pArena + 1;
         entry->cbData = pArena->size & ARENA_SIZE_MASK;
         entry->cbOverhead = sizeof(ARENA_INUSE);
-        entry->wFlags = (pArena->magic == ARENA_PENDING_MAGIC) ?
+        entry->wFlags = (pArena->magic == ARENA_PENDING_MAGIC || pArena->magic == ARENA_LFH_MAGIC) ?
                         PROCESS_HEAP_UNCOMMITTED_RANGE : PROCESS_HEAP_ENTRY_BUSY;
         /* FIXME: can't handle PROCESS_HEAP_ENTRY_MOVEABLE
         and PROCESS_HEAP_ENTRY_DDESHARE yet */
@@ -2246,6 +2386,8 @@ ULONG WINAPI RtlGetProcessHeaps( ULONG count, HANDLE *heaps )
 NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class,
                                          PVOID info, SIZE_T size_in, PSIZE_T size_out)
 {
+    HEAP *heapPtr;
+
     switch (info_class)
     {
     case HeapCompatibilityInformation:
@@ -2254,7 +2396,8 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
         if (size_in < sizeof(ULONG))
             return STATUS_BUFFER_TOO_SMALL;
 
-        *(ULONG *)info = 0; /* standard heap */
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_HANDLE;
+        *(ULONG *)info = heapPtr->compat_info;
         return STATUS_SUCCESS;
 
     default:
@@ -2268,6 +2411,49 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
  */
 NTSTATUS WINAPI RtlSetHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class, PVOID info, SIZE_T size)
 {
-    FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
-    return STATUS_SUCCESS;
+    HEAP *heapPtr;
+    ULONG compat_info;
+    NTSTATUS status = STATUS_SUCCESS;
+
+    switch (info_class)
+    {
+    case HeapCompatibilityInformation:
+        if (size < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_HANDLE;
+        if (heapPtr->flags & HEAP_NO_SERIALIZE) return STATUS_INVALID_PARAMETER;
+
+        compat_info = *(ULONG *)info;
+        if (compat_info != HEAP_STD && compat_info != HEAP_LFH)
+        {
+            FIXME("HeapCompatibilityInformation %u not supported\n", compat_info);
+            return STATUS_UNSUCCESSFUL;
+        }
+
+        RtlEnterCriticalSection( &heapPtr->critSection );
+        if (compat_info == heapPtr->compat_info)
+            ;  /* nothing to do */
+        else if (heapPtr->compat_info != HEAP_STD)
+            status = STATUS_UNSUCCESSFUL;  /* the front end can't be disabled */
+        else
+        {
+            /* the front end is bypassed on heaps that are being debugged */
+            if (!(heapPtr->flags & (HEAP_VALIDATE | HEAP_TAIL_CHECKING_ENABLED | HEAP_FREE_CHECKING_ENABLED)) &&
+                !heapPtr->pending_free && !RUNNING_ON_VALGRIND)
+            {
+                void *ptr = NULL;
+                SIZE_T bins_size = HEAP_NB_LFH_BINS * sizeof(*heapPtr->lfh_bins);
+
+                if (!(status = virtual_alloc( NtCurrentProcess(), &ptr, 0, &bins_size,
+                                              MEM_COMMIT, PAGE_READWRITE, 4 )))
+                    heapPtr->lfh_bins = ptr;
+            }
+            if (!status) heapPtr->compat_info = compat_info;
+        }
+        RtlLeaveCriticalSection( &heapPtr->critSection );
+        return status;
+
+    default:
+        FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
+        return STATUS_SUCCESS;
+    }
 }
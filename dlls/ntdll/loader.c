@@ -134,6 +134,13 @@ static WINE_MODREF *cached_modref;
 static WINE_MODREF *current_modref;
 static WINE_MODREF *last_failed_modref;
 
+/* cache of resolved forwarded exports, indexed by the address of the forward string */
+static struct
+{
+    const char *forward;
+    FARPROC     proc;
+} forward_cache[256];
+
 static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_MODREF** pwm );
 static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved );
 static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
@@ -501,7 +508,11 @@ static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWS
     WCHAR mod_name[32];
     const char *end = strrchr(forward, '.');
     FARPROC proc = NULL;
+    unsigned int cache_idx = ((ULONG_PTR)forward >> 4) % ARRAY_SIZE( forward_cache );
+    /* relay and snoop thunks depend on the importing module, so they can't be cached */
+    BOOL use_cache = !TRACE_ON(relay) && !TRACE_ON(snoop);
 
+    if (use_cache && forward_cache[cache_idx].forward == forward) return forward_cache[cache_idx].proc;
     if (!end) return NULL;
     if ((end - forward) * sizeof(WCHAR) >= sizeof(mod_name)) return NULL;
     ascii_to_unicode( mod_name, forward, end - forward );
@@ -564,6 +575,11 @@ static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWS
             forward, debugstr_w(get_modref(module)->ldr.FullDllName.Buffer),
             debugstr_w(get_modref(module)->ldr.BaseDllName.Buffer) );
     }
+    else if (use_cache)
+    {
+        forward_cache[cache_idx].forward = forward;
+        forward_cache[cache_idx].proc = proc;
+    }
     return proc;
 }
 
@@ -785,8 +801,9 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
     }
 
 done:
-    /* restore old protection of the import address table */
-    NtProtectVirtualMemory( NtCurrentProcess(), &protect_base, &protect_size, protect_old, &protect_old );
+    /* restore old protection of the import address table, unless it was already writable */
+    if (protect_old != PAGE_READWRITE)
+        NtProtectVirtualMemory( NtCurrentProcess(), &protect_base, &protect_size, protect_old, &protect_old );
     *pwm = wmImp;
     return TRUE;
 }
@@ -1311,10 +1328,21 @@ static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved )
     if (status == STATUS_SUCCESS)
     {
         WINE_MODREF *prev = current_modref;
+        LARGE_INTEGER start, end, freq;
+
         current_modref = wm;
 
         call_ldr_notifications( LDR_DLL_NOTIFICATION_REASON_LOADED, &wm->ldr );
+        if (TRACE_ON(loaddll)) NtQueryPerformanceCounter( &start, &freq );
         status = MODULE_InitDLL( wm, DLL_PROCESS_ATTACH, lpReserved );
+        if (TRACE_ON(loaddll))
+        {
+            /* this includes the time spent in DLLs loaded by the entry point */
+            NtQueryPerformanceCounter( &end, NULL );
+            TRACE_(loaddll)( "Initialized module %s in %u us, status %x\n",
+                             debugstr_w(wm->ldr.FullDllName.Buffer),
+                             (ULONG)((end.QuadPart - start.QuadPart) * 1000000 / freq.QuadPart), status );
+        }
         if (status == STATUS_SUCCESS)
         {
             wm->ldr.Flags |= LDR_PROCESS_ATTACHED;
@@ -3108,6 +3136,7 @@ static void free_modref( WINE_MODREF *wm )
     if (wm->ldr.Flags & LDR_WINE_INTERNAL) wine_dll_unload( wm->ldr.SectionHandle );
     NtUnmapViewOfSection( NtCurrentProcess(), wm->ldr.BaseAddress );
     if (cached_modref == wm) cached_modref = NULL;
+    memset( forward_cache, 0, sizeof(forward_cache) );
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
     RtlFreeHeap( GetProcessHeap(), 0, wm->deps );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
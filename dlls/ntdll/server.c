@@ -83,6 +83,7 @@
 #include "ntdll_misc.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(server);
+WINE_DECLARE_DEBUG_CHANNEL(fdcache);
 
 /* Some versions of glibc don't define this */
 #ifndef SCM_RIGHTS
@@ -270,9 +271,40 @@ static void read_reply_data( void *buffer, size_t size )
  */
 static inline unsigned int wait_reply( struct __server_request_info *req )
 {
-    read_reply_data( &req->u.reply, sizeof(req->u.reply) );
-    if (req->u.reply.reply_header.reply_size)
-        read_reply_data( req->reply_data, req->u.reply.reply_header.reply_size );
+    data_size_t max_size = req->u.req.request_header.reply_size;
+    data_size_t size;
+    struct iovec vec[2];
+    int ret;
+
+    if (!max_size)
+    {
+        read_reply_data( &req->u.reply, sizeof(req->u.reply) );
+        return req->u.reply.reply_header.error;
+    }
+
+    /* the server sends the reply header and data with a single writev, and nothing
+     * else can be queued on the reply pipe, so try to fetch both in one syscall */
+    vec[0].iov_base = &req->u.reply;
+    vec[0].iov_len  = sizeof(req->u.reply);
+    vec[1].iov_base = req->reply_data;
+    vec[1].iov_len  = max_size;
+    while ((ret = readv( ntdll_get_thread_data()->reply_fd, vec, 2 )) < 0 && errno == EINTR);
+
+    if (ret < 0)
+    {
+        if (errno == EPIPE) abort_thread(0);
+        server_protocol_perror( "read" );
+    }
+    if (!ret) abort_thread(0);  /* the server closed the connection */
+
+    if (ret < sizeof(req->u.reply))
+    {
+        read_reply_data( (char *)&req->u.reply + ret, sizeof(req->u.reply) - ret );
+        ret = sizeof(req->u.reply);
+    }
+    size = ret - sizeof(req->u.reply);
+    if (req->u.reply.reply_header.reply_size > size)
+        read_reply_data( (char *)req->reply_data + size, req->u.reply.reply_header.reply_size - size );
     return req->u.reply.reply_header.error;
 }
 
@@ -823,11 +855,16 @@ union fd_cache_entry
 C_ASSERT( sizeof(union fd_cache_entry) == sizeof(LONG64) );
 
 #define FD_CACHE_BLOCK_SIZE  (65536 / sizeof(union fd_cache_entry))
-#define FD_CACHE_ENTRIES     128
+#define FD_CACHE_MAX_HANDLES 0x00ffffff  /* size limit of the server handle table */
+#define FD_CACHE_ENTRIES     ((FD_CACHE_MAX_HANDLES + FD_CACHE_BLOCK_SIZE - 1) / FD_CACHE_BLOCK_SIZE)
 
 static union fd_cache_entry *fd_cache[FD_CACHE_ENTRIES];
 static union fd_cache_entry fd_cache_initial_block[FD_CACHE_BLOCK_SIZE];
 
+/* statistics, only maintained when the fdcache channel is enabled */
+static LONG fd_cache_hits;
+static LONG fd_cache_misses;
+
 static inline unsigned int handle_to_index( HANDLE handle, unsigned int *entry )
 {
     unsigned int idx = (wine_server_obj_handle(handle) >> 2) - 1;
@@ -887,7 +924,12 @@ static inline NTSTATUS get_cached_fd( HANDLE handle, int *fd, enum server_fd_typ
 
     if (entry >= FD_CACHE_ENTRIES || !fd_cache[entry]) return STATUS_INVALID_HANDLE;
 
+#ifdef _WIN64
+    /* aligned 64-bit loads are atomic, and avoid bouncing the cache line between threads */
+    cache.data = *(volatile LONG64 *)&fd_cache[entry][idx].data;
+#else
     cache.data = interlocked_cmpxchg64( &fd_cache[entry][idx].data, 0, 0 );
+#endif
     if (!cache.data) return STATUS_INVALID_HANDLE;
 
     /* if fd type is invalid, fd stores an error value */
@@ -938,12 +980,20 @@ int server_get_unix_fd( HANDLE handle, unsigned int wanted_access, int *unix_fd,
     wanted_access &= FILE_READ_DATA | FILE_WRITE_DATA | FILE_APPEND_DATA;
 
     ret = get_cached_fd( handle, &fd, type, &access, options );
-    if (ret != STATUS_INVALID_HANDLE) goto done;
+    if (ret != STATUS_INVALID_HANDLE)
+    {
+        if (TRACE_ON(fdcache)) interlocked_xchg_add( &fd_cache_hits, 1 );
+        goto done;
+    }
 
     server_enter_uninterrupted_section( &fd_cache_section, &sigset );
     ret = get_cached_fd( handle, &fd, type, &access, options );
     if (ret == STATUS_INVALID_HANDLE)
     {
+        if (TRACE_ON(fdcache))
+            TRACE_(fdcache)( "miss for %p, %d hits %d misses\n", handle, fd_cache_hits,
+                             interlocked_xchg_add( &fd_cache_misses, 1 ) + 1 );
+
         SERVER_START_REQ( get_handle_fd )
         {
             req->handle = wine_server_obj_handle( handle );
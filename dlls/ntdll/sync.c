@@ -85,6 +85,8 @@ static inline int interlocked_dec_if_nonzero( int *dest )
 
 static int wait_op = 128; /*FUTEX_WAIT|FUTEX_PRIVATE_FLAG*/
 static int wake_op = 129; /*FUTEX_WAKE|FUTEX_PRIVATE_FLAG*/
+static int wait_bitset_op = 137; /*FUTEX_WAIT_BITSET|FUTEX_PRIVATE_FLAG*/
+static int wake_bitset_op = 138; /*FUTEX_WAKE_BITSET|FUTEX_PRIVATE_FLAG*/
 
 static inline int futex_wait( const int *addr, int val, struct timespec *timeout )
 {
@@ -96,6 +98,16 @@ static inline int futex_wake( const int *addr, int val )
     return syscall( __NR_futex, addr, wake_op, val, NULL, 0, 0 );
 }
 
+static inline int futex_wait_bitset( const int *addr, int val, struct timespec *timeout, int mask )
+{
+    return syscall( __NR_futex, addr, wait_bitset_op, val, timeout, 0, mask );
+}
+
+static inline int futex_wake_bitset( const int *addr, int val, int mask )
+{
+    return syscall( __NR_futex, addr, wake_bitset_op, val, NULL, 0, mask );
+}
+
 static inline int use_futexes(void)
 {
     static int supported = -1;
@@ -107,6 +119,8 @@ static inline int use_futexes(void)
         {
             wait_op = 0; /*FUTEX_WAIT*/
             wake_op = 1; /*FUTEX_WAKE*/
+            wait_bitset_op = 9; /*FUTEX_WAIT_BITSET*/
+            wake_bitset_op = 10; /*FUTEX_WAKE_BITSET*/
             futex_wait( &supported, 10, NULL );
         }
         supported = (errno != ENOSYS);
@@ -1402,31 +1416,37 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE CompletionPort, PULONG_PTR Completi
 NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE port, FILE_IO_COMPLETION_INFORMATION *info, ULONG count,
                                         ULONG *written, LARGE_INTEGER *timeout, BOOLEAN alertable )
 {
+    struct completion_msg msgs[64];
     NTSTATUS ret;
-    ULONG i = 0;
+    ULONG i = 0, j, size;
 
     TRACE("%p %p %u %p %p %u\n", port, info, count, written, timeout, alertable);
 
     for (;;)
     {
+        /* fetch the queued completions in batches */
         while (i < count)
         {
-            SERVER_START_REQ( remove_completion )
+            size = min( count - i, ARRAY_SIZE( msgs ));
+            SERVER_START_REQ( remove_completions )
             {
                 req->handle = wine_server_obj_handle( port );
+                wine_server_set_reply( req, msgs, size * sizeof(*msgs) );
                 if (!(ret = wine_server_call( req )))
                 {
-                    info[i].CompletionKey             = reply->ckey;
-                    info[i].CompletionValue           = reply->cvalue;
-                    info[i].IoStatusBlock.Information = reply->information;
-                    info[i].IoStatusBlock.u.Status    = reply->status;
+                    for (j = 0; j < wine_server_reply_size( reply ) / sizeof(*msgs); j++, i++)
+                    {
+                        info[i].CompletionKey             = msgs[j].ckey;
+                        info[i].CompletionValue           = msgs[j].cvalue;
+                        info[i].IoStatusBlock.Information = msgs[j].information;
+                        info[i].IoStatusBlock.u.Status    = msgs[j].status;
+                    }
                 }
             }
             SERVER_END_REQ;
 
             if (ret != STATUS_SUCCESS) break;
-
-            ++i;
+            if (j < size) break;  /* queue is empty now */
         }
 
         if (i || ret != STATUS_PENDING)
@@ -1529,7 +1549,7 @@ NTSTATUS WINAPI NtQueryIoCompletion( HANDLE CompletionPort, IO_COMPLETION_INFORM
 }
 
 NTSTATUS NTDLL_AddCompletion( HANDLE hFile, ULONG_PTR CompletionValue,
-                              NTSTATUS CompletionStatus, ULONG Information, BOOL async )
+                              NTSTATUS CompletionStatus, ULONG Information, BOOL async, HANDLE event )
 {
     NTSTATUS status;
 
@@ -1540,6 +1560,7 @@ NTSTATUS NTDLL_AddCompletion( HANDLE hFile, ULONG_PTR CompletionValue,
         req->status      = CompletionStatus;
         req->information = Information;
         req->async       = async;
+        req->event       = wine_server_obj_handle( event );
         status = wine_server_call( req );
     }
     SERVER_END_REQ;
@@ -1783,15 +1804,266 @@ static inline void srwlock_leave_shared( RTL_SRWLOCK *lock, unsigned int val )
         NtReleaseKeyedEvent( 0, srwlock_key_exclusive(lock), FALSE, NULL );
 }
 
+#ifdef __linux__
+
+/* Futex-based SRW lock implementation:
+ *
+ * The kernel takes care of queueing the waiting threads, so the lock value
+ * only needs to describe the current owners and whether anybody has to be
+ * woken up on release. The layout looks like this:
+ *
+ *    31 - Exclusive lock bit, set if the lock is owned exclusively.
+ * 30-16 - Number of exclusive waiters. Unlike the keyed event implementation,
+ *         this does not include the thread owning the lock.
+ *    15 - Set if there are shared waiters, so that releasing an exclusive
+ *         lock can skip the wake call in the common case.
+ *  14-0 - Number of shared owners. Shared waiters are not included.
+ *
+ * Exclusive and shared waiters sleep on the same futex, using a different
+ * bitset each so that they can be woken up independently.
+ */
+
+#define SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT        0x80000000
+#define SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK    0x7fff0000
+#define SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_INC     0x00010000
+#define SRWLOCK_FUTEX_SHARED_WAITERS_BIT        0x00008000
+#define SRWLOCK_FUTEX_SHARED_OWNERS_MASK        0x00007fff
+#define SRWLOCK_FUTEX_SHARED_OWNERS_INC         0x00000001
+
+#define SRWLOCK_FUTEX_BITSET_EXCLUSIVE  1
+#define SRWLOCK_FUTEX_BITSET_SHARED     2
+
+static NTSTATUS fast_try_acquire_srw_exclusive( RTL_SRWLOCK *lock )
+{
+    int old, new;
+    NTSTATUS ret;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    do
+    {
+        old = *(int *)&lock->Ptr;
+
+        if (!(old & SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT) && !(old & SRWLOCK_FUTEX_SHARED_OWNERS_MASK))
+        {
+            new = old | SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT;
+            ret = STATUS_SUCCESS;
+        }
+        else
+        {
+            new = old;
+            ret = STATUS_TIMEOUT;
+        }
+    } while (interlocked_cmpxchg( (int *)&lock->Ptr, new, old ) != old);
+
+    return ret;
+}
+
+static NTSTATUS fast_acquire_srw_exclusive( RTL_SRWLOCK *lock )
+{
+    int old, new;
+    BOOLEAN wait;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    /* register ourselves as an exclusive waiter first, so that new shared
+     * owners can't starve us */
+    do
+    {
+        old = *(int *)&lock->Ptr;
+        new = old + SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_INC;
+        if (!(new & SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK)) RtlRaiseStatus( STATUS_RESOURCE_NOT_OWNED );
+    } while (interlocked_cmpxchg( (int *)&lock->Ptr, new, old ) != old);
+
+    for (;;)
+    {
+        do
+        {
+            old = *(int *)&lock->Ptr;
+
+            if (!(old & SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT) && !(old & SRWLOCK_FUTEX_SHARED_OWNERS_MASK))
+            {
+                new = (old | SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT) - SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_INC;
+                wait = FALSE;
+            }
+            else
+            {
+                new = old;
+                wait = TRUE;
+            }
+        } while (interlocked_cmpxchg( (int *)&lock->Ptr, new, old ) != old);
+
+        if (!wait) return STATUS_SUCCESS;
+
+        futex_wait_bitset( (int *)&lock->Ptr, new, NULL, SRWLOCK_FUTEX_BITSET_EXCLUSIVE );
+    }
+}
+
+static NTSTATUS fast_try_acquire_srw_shared( RTL_SRWLOCK *lock )
+{
+    int old, new;
+    NTSTATUS ret;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    do
+    {
+        old = *(int *)&lock->Ptr;
+
+        if (!(old & SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT) && !(old & SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK))
+        {
+            new = old + SRWLOCK_FUTEX_SHARED_OWNERS_INC;
+            if (!(new & SRWLOCK_FUTEX_SHARED_OWNERS_MASK)) RtlRaiseStatus( STATUS_RESOURCE_NOT_OWNED );
+            ret = STATUS_SUCCESS;
+        }
+        else
+        {
+            new = old;
+            ret = STATUS_TIMEOUT;
+        }
+    } while (interlocked_cmpxchg( (int *)&lock->Ptr, new, old ) != old);
+
+    return ret;
+}
+
+static NTSTATUS fast_acquire_srw_shared( RTL_SRWLOCK *lock )
+{
+    int old, new;
+    BOOLEAN wait;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    for (;;)
+    {
+        do
+        {
+            old = *(int *)&lock->Ptr;
+
+            if (!(old & SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT) && !(old & SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK))
+            {
+                new = old + SRWLOCK_FUTEX_SHARED_OWNERS_INC;
+                if (!(new & SRWLOCK_FUTEX_SHARED_OWNERS_MASK)) RtlRaiseStatus( STATUS_RESOURCE_NOT_OWNED );
+                wait = FALSE;
+            }
+            else
+            {
+                new = old | SRWLOCK_FUTEX_SHARED_WAITERS_BIT;
+                wait = TRUE;
+            }
+        } while (interlocked_cmpxchg( (int *)&lock->Ptr, new, old ) != old);
+
+        if (!wait) return STATUS_SUCCESS;
+
+        futex_wait_bitset( (int *)&lock->Ptr, new, NULL, SRWLOCK_FUTEX_BITSET_SHARED );
+    }
+}
+
+static NTSTATUS fast_release_srw_exclusive( RTL_SRWLOCK *lock )
+{
+    int old, new;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    do
+    {
+        old = *(int *)&lock->Ptr;
+
+        if (!(old & SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT))
+        {
+            ERR("Lock %p is not owned exclusive! (%#x)\n", lock, old);
+            return STATUS_RESOURCE_NOT_OWNED;
+        }
+
+        new = old & ~SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT;
+
+        if (!(new & SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK))
+            new &= ~SRWLOCK_FUTEX_SHARED_WAITERS_BIT;
+    } while (interlocked_cmpxchg( (int *)&lock->Ptr, new, old ) != old);
+
+    /* exclusive waiters are processed first, followed by the shared waiters */
+    if (new & SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK)
+        futex_wake_bitset( (int *)&lock->Ptr, 1, SRWLOCK_FUTEX_BITSET_EXCLUSIVE );
+    else if (old & SRWLOCK_FUTEX_SHARED_WAITERS_BIT)
+        futex_wake_bitset( (int *)&lock->Ptr, INT_MAX, SRWLOCK_FUTEX_BITSET_SHARED );
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS fast_release_srw_shared( RTL_SRWLOCK *lock )
+{
+    int old, new;
+
+    if (!use_futexes()) return STATUS_NOT_IMPLEMENTED;
+
+    do
+    {
+        old = *(int *)&lock->Ptr;
+
+        if (old & SRWLOCK_FUTEX_EXCLUSIVE_LOCK_BIT)
+        {
+            ERR("Lock %p is owned exclusive! (%#x)\n", lock, old);
+            return STATUS_RESOURCE_NOT_OWNED;
+        }
+        if (!(old & SRWLOCK_FUTEX_SHARED_OWNERS_MASK))
+        {
+            ERR("Lock %p is not owned shared! (%#x)\n", lock, old);
+            return STATUS_RESOURCE_NOT_OWNED;
+        }
+
+        new = old - SRWLOCK_FUTEX_SHARED_OWNERS_INC;
+    } while (interlocked_cmpxchg( (int *)&lock->Ptr, new, old ) != old);
+
+    /* only the last shared owner needs to wake up an exclusive waiter */
+    if (!(new & SRWLOCK_FUTEX_SHARED_OWNERS_MASK) && (new & SRWLOCK_FUTEX_EXCLUSIVE_WAITERS_MASK))
+        futex_wake_bitset( (int *)&lock->Ptr, 1, SRWLOCK_FUTEX_BITSET_EXCLUSIVE );
+
+    return STATUS_SUCCESS;
+}
+
+#else
+
+static NTSTATUS fast_try_acquire_srw_exclusive( RTL_SRWLOCK *lock )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static NTSTATUS fast_acquire_srw_exclusive( RTL_SRWLOCK *lock )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static NTSTATUS fast_try_acquire_srw_shared( RTL_SRWLOCK *lock )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static NTSTATUS fast_acquire_srw_shared( RTL_SRWLOCK *lock )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static NTSTATUS fast_release_srw_exclusive( RTL_SRWLOCK *lock )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static NTSTATUS fast_release_srw_shared( RTL_SRWLOCK *lock )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+#endif
+
 /***********************************************************************
  *              RtlInitializeSRWLock (NTDLL.@)
  *
  * NOTES
  *  Please note that SRWLocks do not keep track of the owner of a lock.
  *  It doesn't make any difference which thread for example unlocks an
- *  SRWLock (see corresponding tests). This implementation uses two
- *  keyed events (one for the exclusive waiters and one for the shared
- *  waiters) and is limited to 2^15-1 waiting threads.
+ *  SRWLock (see corresponding tests). When futexes are available the
+ *  lock is handled entirely in-process; otherwise this implementation
+ *  uses two keyed events (one for the exclusive waiters and one for the
+ *  shared waiters) and is limited to 2^15-1 waiting threads.
  */
 void WINAPI RtlInitializeSRWLock( RTL_SRWLOCK *lock )
 {
@@ -1808,6 +2080,9 @@ void WINAPI RtlInitializeSRWLock( RTL_SRWLOCK *lock )
  */
 void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 {
+    if (fast_acquire_srw_exclusive( lock ) != STATUS_NOT_IMPLEMENTED)
+        return;
+
     if (srwlock_lock_exclusive( (unsigned int *)&lock->Ptr, SRWLOCK_RES_EXCLUSIVE ))
         NtWaitForKeyedEvent( 0, srwlock_key_exclusive(lock), FALSE, NULL );
 }
@@ -1822,6 +2097,10 @@ void WINAPI RtlAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 void WINAPI RtlAcquireSRWLockShared( RTL_SRWLOCK *lock )
 {
     unsigned int val, tmp;
+
+    if (fast_acquire_srw_shared( lock ) != STATUS_NOT_IMPLEMENTED)
+        return;
+
     /* Acquires a shared lock. If it's currently not possible to add elements to
      * the shared queue, then request exclusive access instead. */
     for (val = *(unsigned int *)&lock->Ptr;; val = tmp)
@@ -1852,6 +2131,9 @@ void WINAPI RtlAcquireSRWLockShared( RTL_SRWLOCK *lock )
  */
 void WINAPI RtlReleaseSRWLockExclusive( RTL_SRWLOCK *lock )
 {
+    if (fast_release_srw_exclusive( lock ) != STATUS_NOT_IMPLEMENTED)
+        return;
+
     srwlock_leave_exclusive( lock, srwlock_unlock_exclusive( (unsigned int *)&lock->Ptr,
                              - SRWLOCK_RES_EXCLUSIVE ) - SRWLOCK_RES_EXCLUSIVE );
 }
@@ -1861,6 +2143,9 @@ void WINAPI RtlReleaseSRWLockExclusive( RTL_SRWLOCK *lock )
  */
 void WINAPI RtlReleaseSRWLockShared( RTL_SRWLOCK *lock )
 {
+    if (fast_release_srw_shared( lock ) != STATUS_NOT_IMPLEMENTED)
+        return;
+
     srwlock_leave_shared( lock, srwlock_lock_exclusive( (unsigned int *)&lock->Ptr,
                           - SRWLOCK_RES_SHARED ) - SRWLOCK_RES_SHARED );
 }
@@ -1874,6 +2159,11 @@ void WINAPI RtlReleaseSRWLockShared( RTL_SRWLOCK *lock )
  */
 BOOLEAN WINAPI RtlTryAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 {
+    NTSTATUS ret;
+
+    if ((ret = fast_try_acquire_srw_exclusive( lock )) != STATUS_NOT_IMPLEMENTED)
+        return (ret == STATUS_SUCCESS);
+
     return interlocked_cmpxchg( (int *)&lock->Ptr, SRWLOCK_MASK_IN_EXCLUSIVE |
                                 SRWLOCK_RES_EXCLUSIVE, 0 ) == 0;
 }
@@ -1884,6 +2174,11 @@ BOOLEAN WINAPI RtlTryAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
 BOOLEAN WINAPI RtlTryAcquireSRWLockShared( RTL_SRWLOCK *lock )
 {
     unsigned int val, tmp;
+    NTSTATUS ret;
+
+    if ((ret = fast_try_acquire_srw_shared( lock )) != STATUS_NOT_IMPLEMENTED)
+        return (ret == STATUS_SUCCESS);
+
     for (val = *(unsigned int *)&lock->Ptr;; val = tmp)
     {
         if (val & SRWLOCK_MASK_EXCLUSIVE_QUEUE)
@@ -1897,6 +1897,163 @@ static void test_tp_multi_wait(void)
     CloseHandle(semaphore);
 }
 
+static void test_tp_wait_rearm(void)
+{
+    TP_CALLBACK_ENVIRON environment;
+    HANDLE events[MAXIMUM_WAIT_OBJECTS];
+    TP_WAIT *waits[MAXIMUM_WAIT_OBJECTS];
+    HANDLE semaphore;
+    NTSTATUS status;
+    TP_POOL *pool;
+    DWORD result;
+    int i;
+
+    semaphore = CreateSemaphoreW(NULL, 0, ARRAY_SIZE(events), NULL);
+    ok(semaphore != NULL, "failed to create semaphore\n");
+    multi_wait_info.semaphore = semaphore;
+
+    pool = NULL;
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %x\n", status);
+    ok(pool != NULL, "expected pool != NULL\n");
+
+    memset(&environment, 0, sizeof(environment));
+    environment.Version = 1;
+    environment.Pool = pool;
+
+    for (i = 0; i < ARRAY_SIZE(events); i++)
+    {
+        events[i] = CreateEventW(NULL, FALSE, FALSE, NULL);
+        ok(events[i] != NULL, "failed to create event %i\n", i);
+
+        waits[i] = NULL;
+        status = pTpAllocWait(&waits[i], multi_wait_cb, (void *)(DWORD_PTR)i, &environment);
+        ok(!status, "TpAllocWait failed with status %x\n", status);
+        ok(waits[i] != NULL, "expected waits[%d] != NULL\n", i);
+    }
+
+    /* arm as many wait objects as a single wait thread can handle, then
+     * take the slot of the first one, and re-arm it */
+    for (i = 0; i < ARRAY_SIZE(events) - 1; i++)
+        pTpSetWait(waits[i], events[i], NULL);
+    pTpSetWait(waits[0], NULL, NULL);
+    pTpSetWait(waits[i], events[i], NULL);
+    pTpSetWait(waits[0], events[0], NULL);
+
+    multi_wait_info.result = 0xdeadbeef;
+    SetEvent(events[0]);
+    result = WaitForSingleObject(semaphore, 1000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+    ok(multi_wait_info.result == 0, "expected result 0, got %u\n", multi_wait_info.result);
+
+    /* re-arm a wait object while it is pending */
+    pTpSetWait(waits[1], events[1], NULL);
+    multi_wait_info.result = 0xdeadbeef;
+    SetEvent(events[1]);
+    result = WaitForSingleObject(semaphore, 1000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+    ok(multi_wait_info.result == 1, "expected result 1, got %u\n", multi_wait_info.result);
+
+    result = WaitForSingleObject(semaphore, 50);
+    ok(result == WAIT_TIMEOUT, "WaitForSingleObject returned %u\n", result);
+
+    for (i = 0; i < ARRAY_SIZE(events); i++)
+        pTpSetWait(waits[i], NULL, NULL);
+
+    for (i = 0; i < ARRAY_SIZE(events); i++)
+    {
+        pTpReleaseWait(waits[i]);
+        CloseHandle(events[i]);
+    }
+
+    pTpReleasePool(pool);
+    CloseHandle(semaphore);
+}
+
+static char priority_order[4];
+static LONG priority_count;
+
+static void CALLBACK priority_block_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    HANDLE *handles = userdata;
+    ReleaseSemaphore(handles[0], 1, NULL);
+    WaitForSingleObject(handles[1], 1000);
+}
+
+static void CALLBACK priority_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    LONG index = InterlockedIncrement(&priority_count) - 1;
+    if (index < ARRAY_SIZE(priority_order) - 1)
+        priority_order[index] = (char)(DWORD_PTR)userdata;
+}
+
+static void test_tp_priority(void)
+{
+    static const struct
+    {
+        TP_CALLBACK_PRIORITY priority;
+        char id;
+    }
+    callbacks[] =
+    {
+        { TP_CALLBACK_PRIORITY_LOW,    'l' },
+        { TP_CALLBACK_PRIORITY_NORMAL, 'n' },
+        { TP_CALLBACK_PRIORITY_HIGH,   'h' },
+    };
+    TP_CALLBACK_ENVIRON_V3 environment;
+    HANDLE handles[2];
+    NTSTATUS status;
+    TP_POOL *pool;
+    DWORD result;
+    int i;
+
+    handles[0] = CreateSemaphoreA(NULL, 0, 1, NULL);
+    ok(handles[0] != NULL, "CreateSemaphoreA failed %u\n", GetLastError());
+    handles[1] = CreateEventA(NULL, TRUE, FALSE, NULL);
+    ok(handles[1] != NULL, "CreateEventA failed %u\n", GetLastError());
+
+    /* allocate new threadpool with only one thread */
+    pool = NULL;
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %x\n", status);
+    ok(pool != NULL, "expected pool != NULL\n");
+    pTpSetPoolMaxThreads(pool, 1);
+
+    memset(&environment, 0, sizeof(environment));
+    environment.Version = 3;
+    environment.Pool = pool;
+    environment.CallbackPriority = TP_CALLBACK_PRIORITY_NORMAL;
+    environment.Size = sizeof(environment);
+
+    /* keep the worker thread busy while the callbacks are queued */
+    status = pTpSimpleTryPost(priority_block_cb, handles, (TP_CALLBACK_ENVIRON *)&environment);
+    ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+    result = WaitForSingleObject(handles[0], 1000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+
+    priority_count = 0;
+    memset(priority_order, 0, sizeof(priority_order));
+    for (i = 0; i < ARRAY_SIZE(callbacks); i++)
+    {
+        environment.CallbackPriority = callbacks[i].priority;
+        status = pTpSimpleTryPost(priority_cb, (void *)(DWORD_PTR)callbacks[i].id,
+                                  (TP_CALLBACK_ENVIRON *)&environment);
+        ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+    }
+    SetEvent(handles[1]);
+
+    for (i = 0; i < 100 && priority_count < ARRAY_SIZE(callbacks); i++)
+        Sleep(10);
+    ok(priority_count == ARRAY_SIZE(callbacks), "expected %u callbacks, got %u\n",
+       (DWORD)ARRAY_SIZE(callbacks), priority_count);
+    ok(!strcmp(priority_order, "hnl"), "wrong callback order %s\n", priority_order);
+
+    /* cleanup */
+    pTpReleasePool(pool);
+    CloseHandle(handles[0]);
+    CloseHandle(handles[1]);
+}
+
 START_TEST(threadpool)
 {
     test_RtlQueueWorkItem();
@@ -1916,4 +2073,6 @@ START_TEST(threadpool)
     test_tp_window_length();
     test_tp_wait();
     test_tp_multi_wait();
+    test_tp_wait_rearm();
+    test_tp_priority();
 }
@@ -123,8 +123,8 @@ struct threadpool
     LONG                    objcount;
     BOOL                    shutdown;
     CRITICAL_SECTION        cs;
-    /* pool of work items, locked via .cs */
-    struct list             pool;
+    /* pools of work items, locked via .cs, order matches TP_CALLBACK_PRIORITY - high, normal, low */
+    struct list             pools[3];
     RTL_CONDITION_VARIABLE  update_event;
     /* information about worker threads, locked via .cs */
     int                     max_workers;
@@ -155,6 +155,7 @@ struct threadpool_object
     PTP_SIMPLE_CALLBACK     finalization_callback;
     BOOL                    may_run_long;
     HMODULE                 race_dll;
+    TP_CALLBACK_PRIORITY    priority;
     /* information about the group, locked via .group->cs */
     struct list             group_entry;
     BOOL                    is_group_member;
@@ -284,6 +285,7 @@ struct waitqueue_bucket
 {
     struct list             bucket_entry;
     LONG                    objcount;
+    LONG                    num_waiting;
     struct list             reserved;
     struct list             waiting;
     HANDLE                  update_event;
@@ -763,18 +765,24 @@ static void queue_add_timer(struct queue_timer *t, ULONGLONG time,
 {
     /* We MUST hold the queue cs while calling this function.  */
     struct timer_queue *q = t->q;
-    struct list *ptr = &q->timers;
+    struct list *ptr;
 
     assert(!q->quit || (t->destroy && time == EXPIRE_NEVER));
 
+    /* Timers are usually re-armed with the same relative timeout, so the
+       insertion point is almost always close to the tail of the list.  */
     if (time != EXPIRE_NEVER)
-        LIST_FOR_EACH(ptr, &q->timers)
+    {
+        LIST_FOR_EACH_REV(ptr, &q->timers)
         {
             struct queue_timer *cur = LIST_ENTRY(ptr, struct queue_timer, entry);
-            if (time < cur->expire)
+            if (cur->expire <= time)
                 break;
         }
-    list_add_before(ptr, &t->entry);
+        list_add_after(ptr, &t->entry);
+    }
+    else
+        list_add_tail(&q->timers, &t->entry);
 
     t->expire = time;
 
@@ -1203,6 +1211,32 @@ NTSTATUS WINAPI RtlDeleteTimer(HANDLE TimerQueue, HANDLE Timer,
     return status;
 }
 
+/***********************************************************************
+ *           timerqueue_add_timer    (internal)
+ *
+ * Inserts a timer into the sorted list of pending timers. Has to be
+ * called with timerqueue.cs held.
+ */
+static void timerqueue_add_timer( struct threadpool_object *timer )
+{
+    struct list *ptr;
+
+    assert( timer->type == TP_OBJECT_TYPE_TIMER );
+    assert( !timer->u.timer.timer_pending );
+
+    /* Timers are usually armed with the same relative timeout again and
+     * again, so search for the insertion point starting from the tail. */
+    LIST_FOR_EACH_REV( ptr, &timerqueue.pending_timers )
+    {
+        struct threadpool_object *other_timer = LIST_ENTRY( ptr, struct threadpool_object, u.timer.timer_entry );
+        assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
+        if (other_timer->u.timer.timeout <= timer->u.timer.timeout)
+            break;
+    }
+    list_add_after( ptr, &timer->u.timer.timer_entry );
+    timer->u.timer.timer_pending = TRUE;
+}
+
 /***********************************************************************
  *           timerqueue_thread_proc    (internal)
  */
@@ -1241,15 +1275,7 @@ static void CALLBACK timerqueue_thread_proc( void *param )
                 if (timer->u.timer.timeout <= now.QuadPart)
                     timer->u.timer.timeout = now.QuadPart + 1;
 
-                LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                                     struct threadpool_object, u.timer.timer_entry )
-                {
-                    assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-                    if (timer->u.timer.timeout < other_timer->u.timer.timeout)
-                        break;
-                }
-                list_add_before( &other_timer->u.timer.timer_entry, &timer->u.timer.timer_entry );
-                timer->u.timer.timer_pending = TRUE;
+                timerqueue_add_timer( timer );
             }
         }
 
@@ -1423,6 +1449,8 @@ static void CALLBACK waitqueue_thread_proc( void *param )
                 /* Wait object timed out. */
                 list_remove( &wait->u.wait.wait_entry );
                 list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
+                wait->u.wait.wait_pending = FALSE;
+                bucket->num_waiting--;
                 tp_object_submit( wait, FALSE );
             }
             else
@@ -1460,17 +1488,25 @@ static void CALLBACK waitqueue_thread_proc( void *param )
 
             if (status >= STATUS_WAIT_0 && status < STATUS_WAIT_0 + num_handles)
             {
+                struct waitqueue_bucket *wait_bucket;
+
                 wait = objects[status - STATUS_WAIT_0];
                 assert( wait->type == TP_OBJECT_TYPE_WAIT );
-                if (wait->u.wait.bucket)
+                wait_bucket = wait->u.wait.bucket;
+                if (wait_bucket && wait->u.wait.wait_pending &&
+                    wait->u.wait.handle == handles[status - STATUS_WAIT_0])
                 {
-                    /* Wait object signaled. */
-                    assert( wait->u.wait.bucket == bucket );
+                    /* Wait object signaled. The object might have been moved to
+                     * another bucket in the meantime, but the signal has been
+                     * consumed here, so it has to be delivered anyway. */
                     list_remove( &wait->u.wait.wait_entry );
-                    list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
+                    list_add_tail( &wait_bucket->reserved, &wait->u.wait.wait_entry );
+                    wait->u.wait.wait_pending = FALSE;
+                    wait_bucket->num_waiting--;
+                    if (wait_bucket != bucket) NtSetEvent( wait_bucket->update_event, NULL );
                     tp_object_submit( wait, TRUE );
                 }
-                else
+                else if (!wait_bucket)
                     WARN("wait object %p triggered while object was destroyed\n", wait);
             }
 
@@ -1485,16 +1521,18 @@ static void CALLBACK waitqueue_thread_proc( void *param )
 
         /* Try to merge bucket with other threads. */
         if (waitqueue.num_buckets > 1 && bucket->objcount &&
-            bucket->objcount <= MAXIMUM_WAITQUEUE_OBJECTS * 1 / 3)
+            bucket->num_waiting <= MAXIMUM_WAITQUEUE_OBJECTS * 1 / 3)
         {
             struct waitqueue_bucket *other_bucket;
             LIST_FOR_EACH_ENTRY( other_bucket, &waitqueue.buckets, struct waitqueue_bucket, bucket_entry )
             {
                 if (other_bucket != bucket && other_bucket->objcount &&
-                    other_bucket->objcount + bucket->objcount <= MAXIMUM_WAITQUEUE_OBJECTS * 2 / 3)
+                    other_bucket->num_waiting + bucket->num_waiting <= MAXIMUM_WAITQUEUE_OBJECTS * 2 / 3)
                 {
                     other_bucket->objcount += bucket->objcount;
+                    other_bucket->num_waiting += bucket->num_waiting;
                     bucket->objcount = 0;
+                    bucket->num_waiting = 0;
 
                     /* Update reserved list. */
                     LIST_FOR_EACH_ENTRY( wait, &bucket->reserved, struct threadpool_object, u.wait.wait_entry )
@@ -1534,6 +1572,7 @@ static void CALLBACK waitqueue_thread_proc( void *param )
     TRACE( "terminating wait queue thread\n" );
 
     assert( bucket->objcount == 0 );
+    assert( bucket->num_waiting == 0 );
     assert( list_empty( &bucket->reserved ) );
     assert( list_empty( &bucket->waiting ) );
     NtClose( bucket->update_event );
@@ -1543,46 +1582,23 @@ static void CALLBACK waitqueue_thread_proc( void *param )
 }
 
 /***********************************************************************
- *           tp_waitqueue_lock    (internal)
+ *           tp_waitqueue_alloc_bucket    (internal)
+ *
+ * Creates a new wait queue bucket and the corresponding worker thread.
+ * Has to be called with waitqueue.cs held.
  */
-static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
+static NTSTATUS tp_waitqueue_alloc_bucket( struct waitqueue_bucket **out )
 {
     struct waitqueue_bucket *bucket;
     NTSTATUS status;
     HANDLE thread;
-    assert( wait->type == TP_OBJECT_TYPE_WAIT );
-
-    wait->u.wait.signaled       = 0;
-    wait->u.wait.bucket         = NULL;
-    wait->u.wait.wait_pending   = FALSE;
-    wait->u.wait.timeout        = 0;
-    wait->u.wait.handle         = INVALID_HANDLE_VALUE;
-
-    RtlEnterCriticalSection( &waitqueue.cs );
 
-    /* Try to assign to existing bucket if possible. */
-    LIST_FOR_EACH_ENTRY( bucket, &waitqueue.buckets, struct waitqueue_bucket, bucket_entry )
-    {
-        if (bucket->objcount < MAXIMUM_WAITQUEUE_OBJECTS)
-        {
-            list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
-            wait->u.wait.bucket = bucket;
-            bucket->objcount++;
-
-            status = STATUS_SUCCESS;
-            goto out;
-        }
-    }
-
-    /* Create a new bucket and corresponding worker thread. */
     bucket = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*bucket) );
     if (!bucket)
-    {
-        status = STATUS_NO_MEMORY;
-        goto out;
-    }
+        return STATUS_NO_MEMORY;
 
     bucket->objcount = 0;
+    bucket->num_waiting = 0;
     list_init( &bucket->reserved );
     list_init( &bucket->waiting );
 
@@ -1591,29 +1607,75 @@ static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
     if (status)
     {
         RtlFreeHeap( GetProcessHeap(), 0, bucket );
-        goto out;
+        return status;
     }
 
     status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, NULL, 0, 0,
                                   waitqueue_thread_proc, bucket, &thread, NULL );
-    if (status == STATUS_SUCCESS)
+    if (status)
     {
-        list_add_tail( &waitqueue.buckets, &bucket->bucket_entry );
-        waitqueue.num_buckets++;
+        NtClose( bucket->update_event );
+        RtlFreeHeap( GetProcessHeap(), 0, bucket );
+        return status;
+    }
 
-        list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
-        wait->u.wait.bucket = bucket;
-        bucket->objcount++;
+    list_add_tail( &waitqueue.buckets, &bucket->bucket_entry );
+    waitqueue.num_buckets++;
+    NtClose( thread );
 
-        NtClose( thread );
+    *out = bucket;
+    return STATUS_SUCCESS;
+}
+
+/***********************************************************************
+ *           tp_waitqueue_find_bucket    (internal)
+ *
+ * Returns a bucket which is able to wait for at least one more object,
+ * creating a new one if necessary. Has to be called with waitqueue.cs held.
+ */
+static NTSTATUS tp_waitqueue_find_bucket( struct waitqueue_bucket **out )
+{
+    struct waitqueue_bucket *bucket;
+
+    LIST_FOR_EACH_ENTRY( bucket, &waitqueue.buckets, struct waitqueue_bucket, bucket_entry )
+    {
+        if (bucket->num_waiting < MAXIMUM_WAITQUEUE_OBJECTS)
+        {
+            *out = bucket;
+            return STATUS_SUCCESS;
+        }
     }
-    else
+
+    return tp_waitqueue_alloc_bucket( out );
+}
+
+/***********************************************************************
+ *           tp_waitqueue_lock    (internal)
+ */
+static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
+{
+    struct waitqueue_bucket *bucket;
+    NTSTATUS status;
+    assert( wait->type == TP_OBJECT_TYPE_WAIT );
+
+    wait->u.wait.signaled       = 0;
+    wait->u.wait.bucket         = NULL;
+    wait->u.wait.wait_pending   = FALSE;
+    wait->u.wait.timeout        = 0;
+    wait->u.wait.handle         = INVALID_HANDLE_VALUE;
+
+    RtlEnterCriticalSection( &waitqueue.cs );
+
+    /* Only wait objects which are actually waiting occupy a slot in the
+     * bucket, idle objects are just kept on the reserved list. */
+    status = tp_waitqueue_find_bucket( &bucket );
+    if (status == STATUS_SUCCESS)
     {
-        NtClose( bucket->update_event );
-        RtlFreeHeap( GetProcessHeap(), 0, bucket );
+        list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
+        wait->u.wait.bucket = bucket;
+        bucket->objcount++;
     }
 
-out:
     RtlLeaveCriticalSection( &waitqueue.cs );
     return status;
 }
@@ -1632,6 +1694,8 @@ static void tp_waitqueue_unlock( struct threadpool_object *wait )
         assert( bucket->objcount > 0 );
 
         list_remove( &wait->u.wait.wait_entry );
+        if (wait->u.wait.wait_pending)
+            bucket->num_waiting--;
         wait->u.wait.bucket = NULL;
         bucket->objcount--;
 
@@ -1648,6 +1712,7 @@ static void tp_waitqueue_unlock( struct threadpool_object *wait )
 static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
 {
     struct threadpool *pool;
+    unsigned int i;
 
     pool = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*pool) );
     if (!pool)
@@ -1660,7 +1725,8 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     RtlInitializeCriticalSection( &pool->cs );
     pool->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool.cs");
 
-    list_init( &pool->pool );
+    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
+        list_init( &pool->pools[i] );
     RtlInitializeConditionVariable( &pool->update_event );
 
     pool->max_workers           = 500;
@@ -1696,6 +1762,8 @@ static void tp_threadpool_shutdown( struct threadpool *pool )
  */
 static BOOL tp_threadpool_release( struct threadpool *pool )
 {
+    unsigned int i;
+
     if (interlocked_dec( &pool->refcount ))
         return FALSE;
 
@@ -1703,7 +1771,8 @@ static BOOL tp_threadpool_release( struct threadpool *pool )
 
     assert( pool->shutdown );
     assert( !pool->objcount );
-    assert( list_empty( &pool->pool ) );
+    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
+        assert( list_empty( &pool->pools[i] ) );
 
     pool->cs.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &pool->cs );
@@ -1860,6 +1929,7 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
     object->finalization_callback   = NULL;
     object->may_run_long            = 0;
     object->race_dll                = NULL;
+    object->priority                = TP_CALLBACK_PRIORITY_NORMAL;
 
     memset( &object->group_entry, 0, sizeof(object->group_entry) );
     object->is_group_member         = FALSE;
@@ -1887,6 +1957,16 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
 
         if (environment->u.s.Persistent)
             FIXME( "persistent threads not supported yet\n" );
+
+        if (environment->Version == 3)
+        {
+            TP_CALLBACK_ENVIRON_V3 *environment_v3 = (TP_CALLBACK_ENVIRON_V3 *)environment;
+
+            if (environment_v3->CallbackPriority < ARRAY_SIZE(pool->pools))
+                object->priority = environment_v3->CallbackPriority;
+            else
+                FIXME( "invalid callback priority %u\n", environment_v3->CallbackPriority );
+        }
     }
 
     if (object->race_dll)
@@ -1940,17 +2020,20 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
     /* Queue work item and increment refcount. */
     interlocked_inc( &object->refcount );
     if (!object->num_pending_callbacks++)
-        list_add_tail( &pool->pool, &object->pool_entry );
+        list_add_tail( &pool->pools[object->priority], &object->pool_entry );
 
     /* Count how often the object was signaled. */
     if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
         object->u.wait.signaled++;
 
-    /* No new thread started - wake up one existing thread. */
+    /* No new thread started - wake up one existing thread. When all workers
+     * are busy, none of them is waiting, and they check the pools again
+     * before going to sleep, so the wakeup can be skipped. */
     if (status != STATUS_SUCCESS)
     {
         assert( pool->num_workers > 0 );
-        RtlWakeConditionVariable( &pool->update_event );
+        if (pool->num_busy_workers < pool->num_workers)
+            RtlWakeConditionVariable( &pool->update_event );
     }
 
     RtlLeaveCriticalSection( &pool->cs );
@@ -2061,6 +2144,25 @@ static BOOL tp_object_release( struct threadpool_object *object )
     return TRUE;
 }
 
+/***********************************************************************
+ *           threadpool_get_next_item    (internal)
+ *
+ * Returns the next pending object, in priority order.
+ */
+static struct list *threadpool_get_next_item( const struct threadpool *pool )
+{
+    struct list *ptr;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
+    {
+        if ((ptr = list_head( &pool->pools[i] )))
+            break;
+    }
+
+    return ptr;
+}
+
 /***********************************************************************
  *           threadpool_worker_proc    (internal)
  */
@@ -2080,7 +2182,7 @@ static void CALLBACK threadpool_worker_proc( void *param )
     pool->num_busy_workers--;
     for (;;)
     {
-        while ((ptr = list_head( &pool->pool )))
+        while ((ptr = threadpool_get_next_item( pool )))
         {
             struct threadpool_object *object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
             assert( object->num_pending_callbacks > 0 );
@@ -2089,7 +2191,7 @@ static void CALLBACK threadpool_worker_proc( void *param )
              * the end of the pool list. Otherwise remove it from the pool. */
             list_remove( &object->pool_entry );
             if (--object->num_pending_callbacks)
-                list_add_tail( &pool->pool, &object->pool_entry );
+                list_add_tail( &pool->pools[object->priority], &object->pool_entry );
 
             /* For wait objects check if they were signaled or have timed out. */
             if (object->type == TP_OBJECT_TYPE_WAIT)
@@ -2230,7 +2332,7 @@ static void CALLBACK threadpool_worker_proc( void *param )
          * can be terminated. */
         timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
         if (RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout ) == STATUS_TIMEOUT &&
-            !list_head( &pool->pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
+            !threadpool_get_next_item( pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
             (!pool->min_workers && !pool->objcount)))
         {
             break;
@@ -2734,7 +2836,6 @@ BOOL WINAPI TpSetPoolMinThreads( TP_POOL *pool, DWORD minimum )
 VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LONG window_length )
 {
     struct threadpool_object *this = impl_from_TP_TIMER( timer );
-    struct threadpool_object *other_timer;
     BOOL submit_timer = FALSE;
     ULONGLONG timestamp;
 
@@ -2784,20 +2885,11 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
         this->u.timer.period        = period;
         this->u.timer.window_length = window_length;
 
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
-        {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (this->u.timer.timeout < other_timer->u.timer.timeout)
-                break;
-        }
-        list_add_before( &other_timer->u.timer.timer_entry, &this->u.timer.timer_entry );
+        timerqueue_add_timer( this );
 
         /* Wake up the timer thread when the timeout has to be updated. */
         if (list_head( &timerqueue.pending_timers ) == &this->u.timer.timer_entry )
             RtlWakeAllConditionVariable( &timerqueue.update_event );
-
-        this->u.timer.timer_pending = TRUE;
     }
 
     RtlLeaveCriticalSection( &timerqueue.cs );
@@ -2826,6 +2918,8 @@ VOID WINAPI TpSetWait( TP_WAIT *wait, HANDLE handle, LARGE_INTEGER *timeout )
     {
         struct waitqueue_bucket *bucket = this->u.wait.bucket;
         list_remove( &this->u.wait.wait_entry );
+        if (this->u.wait.wait_pending)
+            bucket->num_waiting--;
 
         /* Convert relative timeout to absolute timestamp. */
         if (handle && timeout)
@@ -2844,12 +2938,34 @@ VOID WINAPI TpSetWait( TP_WAIT *wait, HANDLE handle, LARGE_INTEGER *timeout )
             }
         }
 
+        /* Move the wait object to a different bucket if there are no free slots. */
+        if (handle && bucket->num_waiting >= MAXIMUM_WAITQUEUE_OBJECTS)
+        {
+            struct waitqueue_bucket *other_bucket;
+            if (tp_waitqueue_find_bucket( &other_bucket ) == STATUS_SUCCESS)
+            {
+                /* The old thread might still be waiting for the handle, make
+                 * it rebuild its handle array. */
+                NtSetEvent( bucket->update_event, NULL );
+                bucket->objcount--;
+                other_bucket->objcount++;
+                this->u.wait.bucket = bucket = other_bucket;
+            }
+            else
+            {
+                ERR( "failed to allocate wait queue bucket for %p\n", wait );
+                handle = NULL;
+            }
+        }
+
         /* Add wait object back into one of the queues. */
         if (handle)
         {
             list_add_tail( &bucket->waiting, &this->u.wait.wait_entry );
             this->u.wait.wait_pending = TRUE;
             this->u.wait.timeout = timestamp;
+            bucket->num_waiting++;
+            assert( bucket->num_waiting <= MAXIMUM_WAITQUEUE_OBJECTS );
         }
         else
         {
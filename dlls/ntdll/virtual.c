@@ -121,6 +121,8 @@ static RTL_CRITICAL_SECTION csVirtual = { &critsect_debug, -1, 0, 0, 0, 0 };
 
 static const UINT default_alignment = 16;
 static const UINT_PTR default_alignment_mask = 0xffff;
+static const UINT large_page_shift = 21;  /* matches GetLargePageMinimum */
+static const UINT_PTR large_page_mask = 0x1fffff;
 #ifdef __i386__
 static const UINT page_shift = 12;
 static const UINT_PTR page_mask = 0xfff;
@@ -2538,6 +2540,32 @@ void virtual_set_large_address_space(void)
 }
 
 
+/***********************************************************************
+ *             has_lock_memory_privilege
+ *
+ * Check whether the caller's token has SeLockMemoryPrivilege enabled.
+ */
+static BOOL has_lock_memory_privilege(void)
+{
+    PRIVILEGE_SET privs;
+    BOOLEAN ret = FALSE;
+    HANDLE token;
+
+    if (NtOpenThreadToken( GetCurrentThread(), TOKEN_QUERY, TRUE, &token ) &&
+        NtOpenProcessToken( NtCurrentProcess(), TOKEN_QUERY, &token ))
+        return FALSE;
+
+    privs.PrivilegeCount = 1;
+    privs.Control = PRIVILEGE_SET_ALL_NECESSARY;
+    privs.Privilege[0].Luid.LowPart = SE_LOCK_MEMORY_PRIVILEGE;
+    privs.Privilege[0].Luid.HighPart = 0;
+    privs.Privilege[0].Attributes = 0;
+    if (NtPrivilegeCheck( token, &privs, &ret )) ret = FALSE;
+    NtClose( token );
+    return ret;
+}
+
+
 /***********************************************************************
  *             virtual_alloc
  *
@@ -2558,6 +2586,15 @@ NTSTATUS virtual_alloc( HANDLE process, PVOID *ret, ULONG zero_bits,
 
     TRACE("%p %p %i %08lx %x %08x %i\n", process, *ret, zero_bits, size, type, protect, alignment );
 
+    if (type & MEM_LARGE_PAGES)
+    {
+        /* large pages must be reserved and committed at once, in whole large pages */
+        if ((type & (MEM_COMMIT | MEM_RESERVE)) != (MEM_COMMIT | MEM_RESERVE) ||
+            (size & large_page_mask) || ((UINT_PTR)*ret & large_page_mask))
+            return STATUS_INVALID_PARAMETER;
+        if (!has_lock_memory_privilege()) return STATUS_PRIVILEGE_NOT_HELD;
+        alignment = max( alignment, large_page_shift );
+    }
     alignment = max( alignment, page_shift );
     mask = (1 << alignment) - 1;
 
@@ -2621,7 +2658,7 @@ NTSTATUS virtual_alloc( HANDLE process, PVOID *ret, ULONG zero_bits,
     /* Compute the alloc type flags */
 
     if (!(type & (MEM_COMMIT | MEM_RESERVE | MEM_RESET)) ||
-        (type & ~(MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET)))
+        (type & ~(MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET | MEM_LARGE_PAGES)))
     {
         WARN("called with wrong alloc type flags (%08x) !\n", type);
         return STATUS_INVALID_PARAMETER;
@@ -2644,6 +2681,11 @@ NTSTATUS virtual_alloc( HANDLE process, PVOID *ret, ULONG zero_bits,
             else status = map_view( &view, base, size, mask, type & MEM_TOP_DOWN, vprot, zero_bits );
 
             if (status == STATUS_SUCCESS) base = view->base;
+#ifdef MADV_HUGEPAGE
+            /* let the kernel back the range with transparent huge pages */
+            if (status == STATUS_SUCCESS && (type & MEM_LARGE_PAGES))
+                madvise( base, size, MADV_HUGEPAGE );
+#endif
         }
     }
     else if (type & MEM_RESET)
@@ -21,6 +21,7 @@
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 
 #define WINED3D_INITIAL_CS_SIZE 4096
 
@@ -2632,6 +2633,14 @@ static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
     InterlockedExchange(&queue->head, (queue->head + packet_size) & (WINED3D_CS_QUEUE_SIZE - 1));
 
+    if (TRACE_ON(d3d_perf))
+    {
+        LONG depth = (queue->head - *(volatile LONG *)&queue->tail) & (WINED3D_CS_QUEUE_SIZE - 1);
+
+        if (depth > cs->max_queue_depth)
+            cs->max_queue_depth = depth;
+    }
+
     if (InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
         SetEvent(cs->event);
 }
@@ -2649,6 +2658,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
     size_t queue_size = ARRAY_SIZE(queue->data);
     size_t header_size, packet_size, remaining;
     struct wined3d_cs_packet *packet;
+    BOOL stalled = FALSE;
 
     header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
     size = (size + header_size - 1) & ~(header_size - 1);
@@ -2696,8 +2706,14 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
         if (new_pos < tail && new_pos)
             break;
 
-        TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
-                head, tail, (unsigned long)packet_size);
+        if (!stalled)
+        {
+            TRACE_(d3d_perf)("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
+                    head, tail, (unsigned long)packet_size);
+            ++cs->full_stall_count;
+            stalled = TRUE;
+        }
+        wined3d_pause();
     }
 
     packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
@@ -2718,6 +2734,10 @@ static void wined3d_cs_mt_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(cs, queue_id);
 
+    if (cs->queue[queue_id].head == *(volatile LONG *)&cs->queue[queue_id].tail)
+        return;
+
+    ++cs->finish_stall_count;
     while (cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
         wined3d_pause();
 }
@@ -2893,6 +2913,8 @@ void wined3d_cs_destroy(struct wined3d_cs *cs)
 {
     if (cs->thread)
     {
+        TRACE_(d3d_perf)("Command stream %p: %u queue full stalls, %u finish stalls, maximum queue depth %u bytes.\n",
+                cs, cs->full_stall_count, cs->finish_stall_count, cs->max_queue_depth);
         wined3d_cs_emit_stop(cs);
         CloseHandle(cs->thread);
         if (!CloseHandle(cs->event))
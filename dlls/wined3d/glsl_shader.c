@@ -133,6 +133,11 @@ struct shader_glsl_priv
     struct wined3d_string_buffer shader_buffer;
     struct wined3d_string_buffer_list string_buffers;
     struct wine_rb_tree program_lookup;
+    struct wine_rb_tree shader_cache;
+    struct list shader_cache_lru;
+    unsigned int shader_cache_count;
+    unsigned int shader_cache_hits;
+    unsigned int shader_cache_misses;
     struct constant_heap vconst_heap;
     struct constant_heap pconst_heap;
     unsigned char *stack;
@@ -271,6 +276,25 @@ struct glsl_program_key
     GLuint cs_id;
 };
 
+/* Compiled shader objects which are no longer used by any wined3d shader,
+ * kept around in case the same GLSL source is generated again. */
+#define WINED3D_GLSL_SHADER_CACHE_SIZE 256
+
+struct glsl_shader_cache_key
+{
+    GLenum type;
+    size_t length;
+    const char *source;
+};
+
+struct glsl_shader_cache_entry
+{
+    struct wine_rb_entry entry;
+    struct list lru_entry;
+    struct glsl_shader_cache_key key;
+    GLuint id;
+};
+
 struct shader_glsl_ctx_priv {
     const struct vs_compile_args    *cur_vs_args;
     const struct ds_compile_args    *cur_ds_args;
@@ -534,6 +558,91 @@ static void shader_glsl_compile(const struct wined3d_gl_info *gl_info, GLuint sh
     print_glsl_info_log(gl_info, shader, FALSE);
 }
 
+/* Context activation is done by the caller. */
+static GLuint shader_glsl_create_shader(struct shader_glsl_priv *priv,
+        const struct wined3d_gl_info *gl_info, GLenum type, const char *src)
+{
+    struct glsl_shader_cache_entry *cache_entry;
+    struct glsl_shader_cache_key key;
+    struct wine_rb_entry *entry;
+    GLuint id;
+
+    key.type = type;
+    key.length = strlen(src);
+    key.source = src;
+    if ((entry = wine_rb_get(&priv->shader_cache, &key)))
+    {
+        cache_entry = WINE_RB_ENTRY_VALUE(entry, struct glsl_shader_cache_entry, entry);
+        id = cache_entry->id;
+
+        wine_rb_remove(&priv->shader_cache, &cache_entry->entry);
+        list_remove(&cache_entry->lru_entry);
+        --priv->shader_cache_count;
+        heap_free(cache_entry);
+
+        ++priv->shader_cache_hits;
+        TRACE("Reusing shader object %u, %u hits, %u misses.\n",
+                id, priv->shader_cache_hits, priv->shader_cache_misses);
+        return id;
+    }
+
+    ++priv->shader_cache_misses;
+    id = GL_EXTCALL(glCreateShader(type));
+    checkGLcall("glCreateShader");
+    shader_glsl_compile(gl_info, id, src);
+
+    return id;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_release_shader(struct shader_glsl_priv *priv,
+        const struct wined3d_gl_info *gl_info, GLenum type, GLuint id)
+{
+    struct glsl_shader_cache_entry *cache_entry;
+    GLint length = 0;
+    char *source;
+
+    GL_EXTCALL(glGetShaderiv(id, GL_SHADER_SOURCE_LENGTH, &length));
+    if (length <= 1 || !(cache_entry = heap_alloc(sizeof(*cache_entry) + length)))
+    {
+        GL_EXTCALL(glDeleteShader(id));
+        checkGLcall("glDeleteShader");
+        return;
+    }
+
+    source = (char *)(cache_entry + 1);
+    GL_EXTCALL(glGetShaderSource(id, length, NULL, source));
+    checkGLcall("glGetShaderSource");
+
+    cache_entry->key.type = type;
+    cache_entry->key.length = strlen(source);
+    cache_entry->key.source = source;
+    cache_entry->id = id;
+
+    if (wine_rb_put(&priv->shader_cache, &cache_entry->key, &cache_entry->entry) == -1)
+    {
+        /* An identical shader object is cached already. */
+        heap_free(cache_entry);
+        GL_EXTCALL(glDeleteShader(id));
+        checkGLcall("glDeleteShader");
+        return;
+    }
+    list_add_head(&priv->shader_cache_lru, &cache_entry->lru_entry);
+
+    if (++priv->shader_cache_count > WINED3D_GLSL_SHADER_CACHE_SIZE)
+    {
+        cache_entry = LIST_ENTRY(list_tail(&priv->shader_cache_lru), struct glsl_shader_cache_entry, lru_entry);
+        TRACE("Evicting shader object %u.\n", cache_entry->id);
+
+        wine_rb_remove(&priv->shader_cache, &cache_entry->entry);
+        list_remove(&cache_entry->lru_entry);
+        --priv->shader_cache_count;
+        GL_EXTCALL(glDeleteShader(cache_entry->id));
+        checkGLcall("glDeleteShader");
+        heap_free(cache_entry);
+    }
+}
+
 /* Context activation is done by the caller. */
 static void shader_glsl_dump_program_source(const struct wined3d_gl_info *gl_info, GLuint program)
 {
@@ -7795,10 +7904,11 @@ static void shader_glsl_generate_ps_epilogue(const struct wined3d_gl_info *gl_in
 
 /* Context activation is done by the caller. */
 static GLuint shader_glsl_generate_pshader(const struct wined3d_context *context,
-        struct wined3d_string_buffer *buffer, struct wined3d_string_buffer_list *string_buffers,
-        const struct wined3d_shader *shader,
+        struct shader_glsl_priv *priv, const struct wined3d_shader *shader,
         const struct ps_compile_args *args, struct ps_np2fixup_info *np2fixup_info)
 {
+    struct wined3d_string_buffer_list *string_buffers = &priv->string_buffers;
+    struct wined3d_string_buffer *buffer = &priv->shader_buffer;
     const struct wined3d_shader_reg_maps *reg_maps = &shader->reg_maps;
     const struct wined3d_shader_version *version = &reg_maps->shader_version;
     const char *prefix = shader_glsl_get_prefix(version->type);
@@ -8095,9 +8205,7 @@ static GLuint shader_glsl_generate_pshader(const struct wined3d_context *context
 
     shader_addline(buffer, "}\n");
 
-    shader_id = GL_EXTCALL(glCreateShader(GL_FRAGMENT_SHADER));
-    TRACE("Compiling shader object %u.\n", shader_id);
-    shader_glsl_compile(gl_info, shader_id, buffer->buffer);
+    shader_id = shader_glsl_create_shader(priv, gl_info, GL_FRAGMENT_SHADER, buffer->buffer);
 
     return shader_id;
 }
@@ -8233,9 +8341,7 @@ static GLuint shader_glsl_generate_vshader(const struct wined3d_context *context
 
     shader_addline(buffer, "}\n");
 
-    shader_id = GL_EXTCALL(glCreateShader(GL_VERTEX_SHADER));
-    TRACE("Compiling shader object %u.\n", shader_id);
-    shader_glsl_compile(gl_info, shader_id, buffer->buffer);
+    shader_id = shader_glsl_create_shader(priv, gl_info, GL_VERTEX_SHADER, buffer->buffer);
 
     return shader_id;
 }
@@ -8368,9 +8474,7 @@ static GLuint shader_glsl_generate_hull_shader(const struct wined3d_context *con
     shader_addline(buffer, "setup_patch_constant_output();\n");
     shader_addline(buffer, "}\n");
 
-    shader_id = GL_EXTCALL(glCreateShader(GL_TESS_CONTROL_SHADER));
-    TRACE("Compiling shader object %u.\n", shader_id);
-    shader_glsl_compile(gl_info, shader_id, buffer->buffer);
+    shader_id = shader_glsl_create_shader(priv, gl_info, GL_TESS_CONTROL_SHADER, buffer->buffer);
 
     return shader_id;
 }
@@ -8471,9 +8575,7 @@ static GLuint shader_glsl_generate_domain_shader(const struct wined3d_context *c
 
     shader_addline(buffer, "}\n");
 
-    shader_id = GL_EXTCALL(glCreateShader(GL_TESS_EVALUATION_SHADER));
-    TRACE("Compiling shader object %u.\n", shader_id);
-    shader_glsl_compile(gl_info, shader_id, buffer->buffer);
+    shader_id = shader_glsl_create_shader(priv, gl_info, GL_TESS_EVALUATION_SHADER, buffer->buffer);
 
     return shader_id;
 }
@@ -8573,9 +8675,7 @@ static GLuint shader_glsl_generate_geometry_shader(const struct wined3d_context
     }
     shader_addline(buffer, "}\n");
 
-    shader_id = GL_EXTCALL(glCreateShader(GL_GEOMETRY_SHADER));
-    TRACE("Compiling shader object %u.\n", shader_id);
-    shader_glsl_compile(gl_info, shader_id, buffer->buffer);
+    shader_id = shader_glsl_create_shader(priv, gl_info, GL_GEOMETRY_SHADER, buffer->buffer);
 
     return shader_id;
 }
@@ -8609,9 +8709,10 @@ static void shader_glsl_generate_shader_epilogue(const struct wined3d_shader_con
 
 /* Context activation is done by the caller. */
 static GLuint shader_glsl_generate_compute_shader(const struct wined3d_context *context,
-        struct wined3d_string_buffer *buffer, struct wined3d_string_buffer_list *string_buffers,
-        const struct wined3d_shader *shader)
+        struct shader_glsl_priv *priv, const struct wined3d_shader *shader)
 {
+    struct wined3d_string_buffer_list *string_buffers = &priv->string_buffers;
+    struct wined3d_string_buffer *buffer = &priv->shader_buffer;
     const struct wined3d_shader_thread_group_size *thread_group_size = &shader->u.cs.thread_group_size;
     const struct wined3d_shader_reg_maps *reg_maps = &shader->reg_maps;
     const struct wined3d_gl_info *gl_info = context->gl_info;
@@ -8642,17 +8743,14 @@ static GLuint shader_glsl_generate_compute_shader(const struct wined3d_context *
     shader_generate_code(shader, buffer, reg_maps, &priv_ctx, NULL, NULL);
     shader_addline(buffer, "}\n");
 
-    shader_id = GL_EXTCALL(glCreateShader(GL_COMPUTE_SHADER));
-    TRACE("Compiling shader object %u.\n", shader_id);
-    shader_glsl_compile(gl_info, shader_id, buffer->buffer);
+    shader_id = shader_glsl_create_shader(priv, gl_info, GL_COMPUTE_SHADER, buffer->buffer);
 
     return shader_id;
 }
 
-static GLuint find_glsl_pshader(const struct wined3d_context *context,
-        struct wined3d_string_buffer *buffer, struct wined3d_string_buffer_list *string_buffers,
-        struct wined3d_shader *shader,
-        const struct ps_compile_args *args, const struct ps_np2fixup_info **np2fixup_info)
+static GLuint find_glsl_pshader(const struct wined3d_context *context, struct shader_glsl_priv *priv,
+        struct wined3d_shader *shader, const struct ps_compile_args *args,
+        const struct ps_np2fixup_info **np2fixup_info)
 {
     struct glsl_ps_compiled_shader *gl_shaders, *new_array;
     struct glsl_shader_private *shader_data;
@@ -8717,8 +8815,8 @@ static GLuint find_glsl_pshader(const struct wined3d_context *context,
 
     pixelshader_update_resource_types(shader, args->tex_types);
 
-    string_buffer_clear(buffer);
-    ret = shader_glsl_generate_pshader(context, buffer, string_buffers, shader, args, np2fixup);
+    string_buffer_clear(&priv->shader_buffer);
+    ret = shader_glsl_generate_pshader(context, priv, shader, args, np2fixup);
     gl_shaders[shader_data->num_gl_shaders++].id = ret;
 
     return ret;
@@ -10279,7 +10377,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
     TRACE("Compiling compute shader %p.\n", shader);
 
     string_buffer_clear(buffer);
-    shader_id = shader_glsl_generate_compute_shader(context, buffer, &priv->string_buffers, shader);
+    shader_id = shader_glsl_generate_compute_shader(context, priv, shader);
     gl_shaders[shader_data->num_gl_shaders++].id = shader_id;
 
     program_id = GL_EXTCALL(glCreateProgram());
@@ -10469,8 +10567,7 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
         struct ps_compile_args ps_compile_args;
         pshader = state->shader[WINED3D_SHADER_TYPE_PIXEL];
         find_ps_compile_args(state, pshader, context->stream_info.position_transformed, &ps_compile_args, context);
-        ps_id = find_glsl_pshader(context, &priv->shader_buffer, &priv->string_buffers,
-                pshader, &ps_compile_args, &np2fixup_info);
+        ps_id = find_glsl_pshader(context, priv, pshader, &ps_compile_args, &np2fixup_info);
         ps_list = &pshader->linked_programs;
     }
     else if (priv->fragment_pipe == &glsl_fragment_pipe
@@ -10975,9 +11072,8 @@ static void shader_glsl_destroy(struct wined3d_shader *shader)
 
                 for (i = 0; i < shader_data->num_gl_shaders; ++i)
                 {
-                    TRACE("Deleting pixel shader %u.\n", gl_shaders[i].id);
-                    GL_EXTCALL(glDeleteShader(gl_shaders[i].id));
-                    checkGLcall("glDeleteShader");
+                    TRACE("Releasing pixel shader %u.\n", gl_shaders[i].id);
+                    shader_glsl_release_shader(priv, gl_info, GL_FRAGMENT_SHADER, gl_shaders[i].id);
                 }
                 heap_free(shader_data->gl_shaders.ps);
 
@@ -10997,9 +11093,8 @@ static void shader_glsl_destroy(struct wined3d_shader *shader)
 
                 for (i = 0; i < shader_data->num_gl_shaders; ++i)
                 {
-                    TRACE("Deleting vertex shader %u.\n", gl_shaders[i].id);
-                    GL_EXTCALL(glDeleteShader(gl_shaders[i].id));
-                    checkGLcall("glDeleteShader");
+                    TRACE("Releasing vertex shader %u.\n", gl_shaders[i].id);
+                    shader_glsl_release_shader(priv, gl_info, GL_VERTEX_SHADER, gl_shaders[i].id);
                 }
                 heap_free(shader_data->gl_shaders.vs);
 
@@ -11019,9 +11114,8 @@ static void shader_glsl_destroy(struct wined3d_shader *shader)
 
                 for (i = 0; i < shader_data->num_gl_shaders; ++i)
                 {
-                    TRACE("Deleting hull shader %u.\n", gl_shaders[i].id);
-                    GL_EXTCALL(glDeleteShader(gl_shaders[i].id));
-                    checkGLcall("glDeleteShader");
+                    TRACE("Releasing hull shader %u.\n", gl_shaders[i].id);
+                    shader_glsl_release_shader(priv, gl_info, GL_TESS_CONTROL_SHADER, gl_shaders[i].id);
                 }
                 heap_free(shader_data->gl_shaders.hs);
 
@@ -11041,9 +11135,8 @@ static void shader_glsl_destroy(struct wined3d_shader *shader)
 
                 for (i = 0; i < shader_data->num_gl_shaders; ++i)
                 {
-                    TRACE("Deleting domain shader %u.\n", gl_shaders[i].id);
-                    GL_EXTCALL(glDeleteShader(gl_shaders[i].id));
-                    checkGLcall("glDeleteShader");
+                    TRACE("Releasing domain shader %u.\n", gl_shaders[i].id);
+                    shader_glsl_release_shader(priv, gl_info, GL_TESS_EVALUATION_SHADER, gl_shaders[i].id);
                 }
                 heap_free(shader_data->gl_shaders.ds);
 
@@ -11063,9 +11156,8 @@ static void shader_glsl_destroy(struct wined3d_shader *shader)
 
                 for (i = 0; i < shader_data->num_gl_shaders; ++i)
                 {
-                    TRACE("Deleting geometry shader %u.\n", gl_shaders[i].id);
-                    GL_EXTCALL(glDeleteShader(gl_shaders[i].id));
-                    checkGLcall("glDeleteShader");
+                    TRACE("Releasing geometry shader %u.\n", gl_shaders[i].id);
+                    shader_glsl_release_shader(priv, gl_info, GL_GEOMETRY_SHADER, gl_shaders[i].id);
                 }
                 heap_free(shader_data->gl_shaders.gs);
 
@@ -11085,9 +11177,8 @@ static void shader_glsl_destroy(struct wined3d_shader *shader)
 
                 for (i = 0; i < shader_data->num_gl_shaders; ++i)
                 {
-                    TRACE("Deleting compute shader %u.\n", gl_shaders[i].id);
-                    GL_EXTCALL(glDeleteShader(gl_shaders[i].id));
-                    checkGLcall("glDeleteShader");
+                    TRACE("Releasing compute shader %u.\n", gl_shaders[i].id);
+                    shader_glsl_release_shader(priv, gl_info, GL_COMPUTE_SHADER, gl_shaders[i].id);
                 }
                 heap_free(shader_data->gl_shaders.cs);
 
@@ -11113,6 +11204,19 @@ static void shader_glsl_destroy(struct wined3d_shader *shader)
     context_release(context);
 }
 
+static int glsl_shader_cache_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct glsl_shader_cache_key *k = key;
+    const struct glsl_shader_cache_entry *cache_entry = WINE_RB_ENTRY_VALUE(entry,
+            const struct glsl_shader_cache_entry, entry);
+
+    if (k->type != cache_entry->key.type)
+        return k->type > cache_entry->key.type ? 1 : -1;
+    if (k->length != cache_entry->key.length)
+        return k->length > cache_entry->key.length ? 1 : -1;
+    return memcmp(k->source, cache_entry->key.source, k->length);
+}
+
 static int glsl_program_key_compare(const void *key, const struct wine_rb_entry *entry)
 {
     const struct glsl_program_key *k = key;
@@ -11222,6 +11326,8 @@ static HRESULT shader_glsl_alloc(struct wined3d_device *device, const struct win
     }
 
     wine_rb_init(&priv->program_lookup, glsl_program_key_compare);
+    wine_rb_init(&priv->shader_cache, glsl_shader_cache_compare);
+    list_init(&priv->shader_cache_lru);
 
     priv->next_constant_version = 1;
     priv->vertex_pipe = vertex_pipe;
@@ -11251,6 +11357,16 @@ fail:
 static void shader_glsl_free(struct wined3d_device *device)
 {
     struct shader_glsl_priv *priv = device->shader_priv;
+    struct glsl_shader_cache_entry *cache_entry, *next;
+    const struct wined3d_gl_info *gl_info = &device->adapter->gl_info;
+
+    LIST_FOR_EACH_ENTRY_SAFE(cache_entry, next, &priv->shader_cache_lru, struct glsl_shader_cache_entry, lru_entry)
+    {
+        GL_EXTCALL(glDeleteShader(cache_entry->id));
+        checkGLcall("glDeleteShader");
+        heap_free(cache_entry);
+    }
+    TRACE("Shader cache: %u hits, %u misses.\n", priv->shader_cache_hits, priv->shader_cache_misses);
 
     wine_rb_destroy(&priv->program_lookup, NULL, NULL);
     constant_heap_free(&priv->pconst_heap);
@@ -3710,6 +3710,11 @@ struct wined3d_cs
     HANDLE event;
     BOOL waiting_for_event;
     LONG pending_presents;
+
+    /* Queue statistics, only updated by the application thread. */
+    unsigned int full_stall_count;
+    unsigned int finish_stall_count;
+    LONG max_queue_depth;
 };
 
 struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device) DECLSPEC_HIDDEN;
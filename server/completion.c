@@ -240,6 +240,38 @@ DECL_HANDLER(remove_completion)
     release_object( completion );
 }
 
+/* get multiple completions from completion port */
+DECL_HANDLER(remove_completions)
+{
+    struct completion* completion = get_completion_obj( current->process, req->handle, IO_COMPLETION_MODIFY_STATE );
+    struct completion_msg *msgs;
+    struct comp_msg *msg;
+    data_size_t i, count;
+
+    if (!completion) return;
+
+    count = min( completion->depth, get_reply_max_size() / sizeof(*msgs) );
+    if (!count)
+        set_error( list_empty( &completion->queue ) ? STATUS_PENDING : STATUS_BUFFER_TOO_SMALL );
+    else if ((msgs = set_reply_data_size( count * sizeof(*msgs) )))
+    {
+        for (i = 0; i < count; i++)
+        {
+            msg = LIST_ENTRY( list_head( &completion->queue ), struct comp_msg, queue_entry );
+            list_remove( &msg->queue_entry );
+            completion->depth--;
+            msgs[i].ckey = msg->ckey;
+            msgs[i].cvalue = msg->cvalue;
+            msgs[i].information = msg->information;
+            msgs[i].status = msg->status;
+            msgs[i].__pad = 0;
+            free( msg );
+        }
+    }
+
+    release_object( completion );
+}
+
 /* get queue depth for completion port */
 DECL_HANDLER(query_completion)
 {
@@ -2640,6 +2640,15 @@ DECL_HANDLER(add_fd_completion)
             add_completion( fd->completion, fd->comp_key, req->cvalue, req->status, req->information );
         release_object( fd );
     }
+    if (req->event)
+    {
+        struct event *event = get_event_obj( current->process, req->event, EVENT_MODIFY_STATE );
+        if (event)
+        {
+            set_event( event );
+            release_object( event );
+        }
+    }
 }
 
 /* set fd completion information */
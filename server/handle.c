@@ -51,7 +51,8 @@ struct handle_table
     struct process      *process;     /* process owning this table */
     int                  count;       /* number of allocated entries */
     int                  last;        /* last used entry */
-    int                  free;        /* first entry that may be free */
+    int                  free_count;  /* number of entries in the free list */
+    int                 *free_list;   /* indices of the closed entries, most recent last */
     struct handle_entry *entries;     /* handle entries */
 };
 
@@ -186,6 +187,7 @@ static void handle_table_destroy( struct object *obj )
         if (obj) release_object_from_handle( obj );
     }
     free( table->entries );
+    free( table->free_list );
 }
 
 /* close all the process handles and free the handle table */
@@ -205,11 +207,13 @@ struct handle_table *alloc_handle_table( struct process *process, int count )
     if (count < MIN_HANDLE_ENTRIES) count = MIN_HANDLE_ENTRIES;
     if (!(table = alloc_object( &handle_table_ops )))
         return NULL;
-    table->process = process;
-    table->count   = count;
-    table->last    = -1;
-    table->free    = 0;
-    if ((table->entries = mem_alloc( count * sizeof(*table->entries) ))) return table;
+    table->process    = process;
+    table->count      = count;
+    table->last       = -1;
+    table->free_count = 0;
+    table->entries    = NULL;
+    if ((table->free_list = mem_alloc( count * sizeof(*table->free_list) )) &&
+        (table->entries = mem_alloc( count * sizeof(*table->entries) ))) return table;
     release_object( table );
     return NULL;
 }
@@ -218,10 +222,17 @@ struct handle_table *alloc_handle_table( struct process *process, int count )
 static int grow_handle_table( struct handle_table *table )
 {
     struct handle_entry *new_entries;
+    int *new_free_list;
     int count = min( table->count * 2, MAX_HANDLE_ENTRIES );
 
     if (count == table->count ||
-        !(new_entries = realloc( table->entries, count * sizeof(struct handle_entry) )))
+        !(new_free_list = realloc( table->free_list, count * sizeof(*new_free_list) )))
+    {
+        set_error( STATUS_INSUFFICIENT_RESOURCES );
+        return 0;
+    }
+    table->free_list = new_free_list;
+    if (!(new_entries = realloc( table->entries, count * sizeof(struct handle_entry) )))
     {
         set_error( STATUS_INSUFFICIENT_RESOURCES );
         return 0;
@@ -231,21 +242,25 @@ static int grow_handle_table( struct handle_table *table )
     return 1;
 }
 
-/* allocate the first free entry in the handle table */
+/* allocate a free entry in the handle table, reusing the most recently closed one */
 static obj_handle_t alloc_entry( struct handle_table *table, void *obj, unsigned int access )
 {
-    struct handle_entry *entry = table->entries + table->free;
+    struct handle_entry *entry;
     int i;
 
-    for (i = table->free; i <= table->last; i++, entry++) if (!entry->ptr) goto found;
-    if (i >= table->count)
+    while (table->free_count)
     {
-        if (!grow_handle_table( table )) return 0;
-        entry = table->entries + i;  /* the entries may have moved */
+        i = table->free_list[--table->free_count];
+        /* ignore entries that have since been trimmed off the end of the table */
+        if (i <= table->last) goto found;
     }
+    /* the free list is empty, so no entry up to the last one is free */
+    i = table->last + 1;
+    if (i >= table->count && !grow_handle_table( table )) return 0;
     table->last = i;
  found:
-    table->free = i + 1;
+    entry = table->entries + i;
+    assert( !entry->ptr );
     entry->ptr    = grab_object_for_handle( obj );
     entry->access = access;
     return index_to_handle(i);
@@ -337,6 +352,7 @@ static void shrink_handle_table( struct handle_table *table )
     struct handle_entry *entry = table->entries + table->last;
     struct handle_entry *new_entries;
     int count = table->count;
+    int i, j;
 
     while (table->last >= 0)
     {
@@ -350,6 +366,11 @@ static void shrink_handle_table( struct handle_table *table )
     if (!(new_entries = realloc( table->entries, count * sizeof(*new_entries) ))) return;
     table->count   = count;
     table->entries = new_entries;
+
+    /* drop the free list entries that are now out of range */
+    for (i = j = 0; i < table->free_count; i++)
+        if (table->free_list[i] <= table->last) table->free_list[j++] = table->free_list[i];
+    table->free_count = j;
 }
 
 /* copy the handle table of the parent process */
@@ -376,6 +397,9 @@ struct handle_table *copy_handle_table( struct process *process, struct process
             if (ptr->access & RESERVED_INHERIT) grab_object_for_handle( ptr->ptr );
             else ptr->ptr = NULL; /* don't inherit this entry */
         }
+        /* build the free list in reverse order so that the lowest entries get reused first */
+        for (i = table->last; i >= 0; i--)
+            if (!table->entries[i].ptr) table->free_list[table->free_count++] = i;
     }
     /* attempt to shrink the table */
     shrink_handle_table( table );
@@ -395,7 +419,7 @@ unsigned int close_handle( struct process *process, obj_handle_t handle )
     if (!obj->ops->close_handle( obj, process, handle )) return STATUS_HANDLE_NOT_CLOSABLE;
     entry->ptr = NULL;
     table = handle_is_global(handle) ? global_table : process->handles;
-    if (entry < table->entries + table->free) table->free = entry - table->entries;
+    table->free_list[table->free_count++] = entry - table->entries;
     if (entry == table->entries + table->last) shrink_handle_table( table );
     release_object_from_handle( obj );
     return STATUS_SUCCESS;
@@ -104,6 +104,8 @@ struct key_value
 #define MAX_NAME_LEN  256    /* max. length of a key name */
 #define MAX_VALUE_LEN 16383  /* max. length of a value name */
 
+#define REGISTRY_FILE_BUFFER_SIZE 0x10000  /* stdio buffer size for registry files */
+
 /* the root of the registry tree */
 static struct key *root_key;
 
@@ -204,6 +206,10 @@ static void dump_path( const struct key *key, const struct key *base, FILE *f )
 /* dump a value to a text file */
 static void dump_value( const struct key_value *value, FILE *f )
 {
+    static const char hex[16] = "0123456789abcdef";
+    const unsigned char *data = value->data;
+    char buffer[256];
+    char *pos = buffer;
     unsigned int i, dw;
     int count;
 
@@ -241,18 +247,27 @@ static void dump_value( const struct key_value *value, FILE *f )
     else count += fprintf( f, "hex(%x):", value->type );
     for (i = 0; i < value->len; i++)
     {
-        count += fprintf( f, "%02x", *((unsigned char *)value->data + i) );
+        if (pos > buffer + sizeof(buffer) - 8)
+        {
+            fwrite( buffer, pos - buffer, 1, f );
+            pos = buffer;
+        }
+        *pos++ = hex[data[i] >> 4];
+        *pos++ = hex[data[i] & 0x0f];
+        count += 2;
         if (i < value->len-1)
         {
-            fputc( ',', f );
+            *pos++ = ',';
             if (++count > 76)
             {
-                fprintf( f, "\\\n  " );
+                memcpy( pos, "\\\n  ", 4 );
+                pos += 4;
                 count = 2;
             }
         }
     }
-    fputc( '\n', f );
+    *pos++ = '\n';
+    fwrite( buffer, pos - buffer, 1, f );
 }
 
 /* save a registry and all its subkeys to a text file */
@@ -1621,6 +1636,12 @@ static int get_prefix_len( struct key *key, const char *name, struct file_load_i
     return res;
 }
 
+/* use a larger stdio buffer than the default to cut down on syscalls for large hives */
+static void set_registry_file_buffer( FILE *f )
+{
+    setvbuf( f, NULL, _IOFBF, REGISTRY_FILE_BUFFER_SIZE );
+}
+
 /* load all the keys from the input file */
 /* prefix_len is the number of key name prefixes to skip, or -1 for autodetection */
 static void load_keys( struct key *key, const char *filename, FILE *f, int prefix_len )
@@ -1707,6 +1728,7 @@ static void load_registry( struct key *key, obj_handle_t handle )
         FILE *f = fdopen( fd, "r" );
         if (f)
         {
+            set_registry_file_buffer( f );
             load_keys( key, NULL, f, -1 );
             fclose( f );
         }
@@ -1721,6 +1743,7 @@ static int load_init_registry_from_file( const char *filename, struct key *key )
 
     if ((f = fopen( filename, "r" )))
     {
+        set_registry_file_buffer( f );
         load_keys( key, filename, f, 0 );
         fclose( f );
         if (get_error() == STATUS_NOT_REGISTRY_FILE)
@@ -1913,6 +1936,7 @@ static void save_registry( struct key *key, obj_handle_t handle )
         FILE *f = fdopen( fd, "w" );
         if (f)
         {
+            set_registry_file_buffer( f );
             save_all_subkeys( key, f );
             if (fclose( f )) file_set_error();
         }
@@ -1982,6 +2006,7 @@ static int save_branch( struct key *key, const char *path )
         dump_operation( key, NULL, "saving" );
     }
 
+    set_registry_file_buffer( f );
     save_all_subkeys( key, f );
     ret = !fclose(f);
 
@@ -328,6 +328,13 @@ static void call_req_handler( struct thread *thread )
     current = NULL;
 }
 
+/* free the variable sized data of the current request */
+static void free_req_data( struct thread *thread )
+{
+    if (thread->req_data != thread->req_buffer) free( thread->req_data );
+    thread->req_data = NULL;
+}
+
 /* read a request from a thread */
 void read_request( struct thread *thread )
 {
@@ -335,20 +342,46 @@ void read_request( struct thread *thread )
 
     if (!thread->req_toread)  /* no pending request */
     {
-        if ((ret = read( get_unix_fd( thread->request_fd ), &thread->req,
-                         sizeof(thread->req) )) != sizeof(thread->req)) goto error;
+        struct iovec vec[2];
+
+        /* the client doesn't send anything else until it gets the reply, so
+         * read the start of the variable sized data along with the request */
+        vec[0].iov_base = &thread->req;
+        vec[0].iov_len  = sizeof(thread->req);
+        vec[1].iov_base = thread->req_buffer;
+        vec[1].iov_len  = sizeof(thread->req_buffer);
+        if ((ret = readv( get_unix_fd( thread->request_fd ), vec, 2 )) < (int)sizeof(thread->req))
+            goto error;
+        ret -= sizeof(thread->req);
+
+        if (ret > thread->req.request_header.request_size)
+        {
+            fatal_protocol_error( thread, "too much data %d for request %d\n",
+                                  ret, thread->req.request_header.req );
+            return;
+        }
         if (!(thread->req_toread = thread->req.request_header.request_size))
         {
             /* no data, handle request at once */
             call_req_handler( thread );
             return;
         }
-        if (!(thread->req_data = malloc( thread->req_toread )))
+        if (thread->req_toread <= sizeof(thread->req_buffer))
+            thread->req_data = thread->req_buffer;
+        else if ((thread->req_data = malloc( thread->req_toread )))
+            memcpy( thread->req_data, thread->req_buffer, ret );
+        else
         {
             fatal_protocol_error( thread, "no memory for %u bytes request %d\n",
                                   thread->req_toread, thread->req.request_header.req );
             return;
         }
+        if (!(thread->req_toread -= ret))
+        {
+            call_req_handler( thread );
+            free_req_data( thread );
+            return;
+        }
     }
 
     /* read the variable sized data */
@@ -362,8 +395,7 @@ void read_request( struct thread *thread )
         if (!(thread->req_toread -= ret))
         {
             call_req_handler( thread );
-            free( thread->req_data );
-            thread->req_data = NULL;
+            free_req_data( thread );
             return;
         }
     }
@@ -21,6 +21,7 @@
 #ifndef __WINE_SERVER_SECURITY_H
 #define __WINE_SERVER_SECURITY_H
 
+extern const LUID SeLockMemoryPrivilege;
 extern const LUID SeIncreaseQuotaPrivilege;
 extern const LUID SeSecurityPrivilege;
 extern const LUID SeTakeOwnershipPrivilege;